@@ -0,0 +1,68 @@
+//
+//  blockTable.c
+//  Cellular Automaton
+//
+
+#include <stddef.h>
+#include "blockTable.h"
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int blockTableFits(const LifeRule* rule) {
+	return rule->states == 2 && rule->neighborhood == NEIGHBORHOOD_MOORE;
+}
+
+void buildBlockTable(uint8_t* table, const LifeRule* rule) {
+	for (unsigned int block=0; block<BLOCK_TABLE_SIZE; block++) {
+		uint8_t next = 0;
+		//	the 2x2 center cells, from top-left (bit 3) to bottom-right (bit 0)
+		for (int r=1; r<=2; r++) {
+			for (int c=1; c<=2; c++) {
+				//	3x3 neighborhood of the cell, bit 8 its NW neighbor
+				unsigned int index = 0;
+				for (int dr=-1; dr<=1; dr++) {
+					for (int dc=-1; dc<=1; dc++) {
+						unsigned int cell = (block >> (15 - 4*(r+dr) - (c+dc))) & 1;
+						index = (index << 1) | cell;
+					}
+				}
+				next = (uint8_t) ((next << 1) | ruleTransition(rule, index));
+			}
+		}
+		table[block] = next;
+	}
+}
+
+void blockRowPair(const uint8_t* table, int** grid, int row, int firstCol, int endCol,
+				  int single, unsigned char* top, unsigned char* bottom) {
+	const int* rows[4] = {grid[row-1], grid[row], grid[row+1], single ? NULL : grid[row+2]};
+	//	cells j-1 to j+2 of each row; starts with the first cell & the one
+	//	before it in bits 1-0
+	unsigned int nibble[4] = {0, 0, 0, 0};
+	for (int k=0; k<4; k++) {
+		if (rows[k] != NULL)
+			nibble[k] = ((rows[k][firstCol-1] != 0) << 1) | (rows[k][firstCol] != 0);
+	}
+
+	for (int j=firstCol; j<endCol; j+=2) {
+		unsigned int block = 0;
+		//	(on an odd width, the last block's east column is past the halo: dead)
+		int east = (j+2 <= endCol);
+		for (int k=0; k<4; k++) {
+			unsigned int cells = 0;
+			if (rows[k] != NULL)
+				cells = ((rows[k][j+1] != 0) << 1) | (east && rows[k][j+2] != 0);
+			nibble[k] = ((nibble[k] << 2) | cells) & 15;
+			block = (block << 4) | nibble[k];
+		}
+		unsigned int next = table[block];
+		top[j] = (next >> 3) & 1;
+		bottom[j] = (next >> 1) & 1;
+		if (j+1 < endCol) {
+			top[j+1] = (next >> 2) & 1;
+			bottom[j+1] = next & 1;
+		}
+	}
+}
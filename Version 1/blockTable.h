@@ -0,0 +1,41 @@
+//
+//  blockTable.h
+//  Cellular Automaton
+//
+//  Table engine for two-state rules on the 8 neighbors: the next states of
+//  the 2x2 cells at the center of a 4x4 block only depend on those 16
+//  cells, so they are computed once per rule for all 65536 blocks.  Rows
+//  are then stepped 2 by 2, 2 cells at a time, with one table read: each
+//  row's 4 cells of the block are kept as a nibble that shifts in 2 new
+//  cells per step, so a cell is only read twice (per row pair), instead of
+//  9 times when counting the neighbors of each cell.
+//
+
+#ifndef BLOCK_TABLE_H
+#define BLOCK_TABLE_H
+
+#include <stdint.h>
+#include "lifeEngine.h"
+
+//	4x4 blocks, as 16-bit indices: bits 15-12 the top row (west to east) ...
+//	bits 3-0 the bottom row
+#define BLOCK_TABLE_SIZE	65536
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	1 if the rule can be put in a table: two states, 8 neighbors
+int blockTableFits(const LifeRule* rule);
+//	table[block]: the next states of the center cells, bit 3 top-left,
+//	2 top-right, 1 bottom-left, 0 bottom-right
+void buildBlockTable(uint8_t* table, const LifeRule* rule);
+//	Next states (0/1) of columns firstCol to endCol-1 of rows row & row+1,
+//	written at the same indices of top & bottom, in a grid whose cells are 0
+//	for dead, anything else for alive, and that has a halo (grid[row-1] and
+//	grid[i][firstCol-1] to grid[i][endCol] are cells).  If single is 1, only
+//	row is computed, and grid[row+2] is not read.
+void blockRowPair(const uint8_t* table, int** grid, int row, int firstCol, int endCol,
+				  int single, unsigned char* top, unsigned char* bottom);
+
+#endif // BLOCK_TABLE_H
@@ -0,0 +1,173 @@
+//
+//  cellEdits.c
+//  Cellular Automaton
+//
+//  The queue has the same design as the command queue (D. Vyukov's bounded
+//  queue), with a single consumer: the pop side needs no compare-and-swap,
+//  since only the thread completing a generation pops, and the generation
+//  barrier orders the threads that take that role one after the other.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "cellEdits.h"
+#include "commandQueue.h"
+
+//---------------------------------------------------------------------------
+//  Private data types
+//---------------------------------------------------------------------------
+
+typedef struct EditSlot {
+	atomic_size_t sequence;
+	CellEdit edit;
+} EditSlot;
+
+//	'O' for live cells, rows top to bottom
+typedef struct StampPattern {
+	const char* name;
+	int numRows;
+	const char* rows[9];
+} StampPattern;
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+EditSlot editSlots[EDIT_QUEUE_CAPACITY];
+_Alignas(64) atomic_size_t editTail;
+//	only read & written by the consumer
+_Alignas(64) size_t editHead;
+
+const StampPattern STAMP_PATTERN[] = {
+	{"glider", 3, {".O.", "..O", "OOO"}},
+	{"lwss", 4, {".O..O", "O....", "O...O", "OOOO."}},
+	{"rpentomino", 3, {".OO", "OO.", ".O."}},
+	{"acorn", 3, {".O.....", "...O...", "OO..OOO"}},
+	{"gun", 9, {"........................O...........",
+				"......................O.O...........",
+				"............OO......OO............OO",
+				"...........O...O....OO............OO",
+				"OO........O.....O...OO..............",
+				"OO........O...O.OO....O.O...........",
+				"..........O.....O.......O...........",
+				"...........O...O....................",
+				"............OO......................"}}
+};
+const int NUM_STAMP_PATTERNS = sizeof(STAMP_PATTERN) / sizeof(STAMP_PATTERN[0]);
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+void paintDisc(int row, int col, int radius, int state, void (*setCell)(int, int, int)) {
+	for (int di=-radius; di<=radius; di++) {
+		for (int dj=-radius; dj<=radius; dj++) {
+			if (di*di + dj*dj <= radius*radius + radius)
+				setCell(row + di, col + dj, state);
+		}
+	}
+}
+
+//	The brush at every cell of the stroke, so that fast drags leave no gaps
+void paintStroke(const CellEdit* edit, int state, void (*setCell)(int, int, int)) {
+	int radius = edit->size < 0 ? 0 : (edit->size > MAX_BRUSH_RADIUS ? MAX_BRUSH_RADIUS : edit->size);
+	int dRow = edit->toRow - edit->row, dCol = edit->toCol - edit->col;
+	int steps = abs(dRow) > abs(dCol) ? abs(dRow) : abs(dCol);
+	for (int s=0; s<=steps; s++) {
+		//	(rounded to the nearest cell)
+		int row = edit->row + (steps > 0 ? (2*s*dRow + (dRow < 0 ? -steps : steps)) / (2*steps) : 0);
+		int col = edit->col + (steps > 0 ? (2*s*dCol + (dCol < 0 ? -steps : steps)) / (2*steps) : 0);
+		paintDisc(row, col, radius, state, setCell);
+	}
+}
+
+void stampPattern(const CellEdit* edit, void (*setCell)(int, int, int)) {
+	if (edit->size < 0 || edit->size >= NUM_STAMP_PATTERNS)
+		return;
+	const StampPattern* pattern = STAMP_PATTERN + edit->size;
+	int width = (int) strlen(pattern->rows[0]);
+	int top = edit->row - pattern->numRows/2, left = edit->col - width/2;
+	for (int r=0; r<pattern->numRows; r++) {
+		for (int c=0; c<width; c++)
+			setCell(top + r, left + c, pattern->rows[r][c] == 'O');
+	}
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void initializeEditQueue(void) {
+	for (size_t k=0; k<EDIT_QUEUE_CAPACITY; k++)
+		atomic_store_explicit(&editSlots[k].sequence, k, memory_order_relaxed);
+	atomic_store(&editTail, 0);
+	editHead = 0;
+}
+
+int pushCellEdit(const CellEdit* edit) {
+	size_t pos = atomic_load_explicit(&editTail, memory_order_relaxed);
+	EditSlot* slot;
+
+	while (1) {
+		slot = editSlots + (pos & (EDIT_QUEUE_CAPACITY-1));
+		size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		long diff = (long) seq - (long) pos;
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&editTail, &pos, pos+1,
+													  memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		//	the consumer has not freed this slot yet --> queue is full
+		else if (diff < 0)
+			return 0;
+		else
+			pos = atomic_load_explicit(&editTail, memory_order_relaxed);
+	}
+
+	slot->edit = *edit;
+	atomic_store_explicit(&slot->sequence, pos+1, memory_order_release);
+	//	(parked workers wait for commands & edits alike)
+	wakeCommandWaiters();
+	return 1;
+}
+
+int editPending(void) {
+	EditSlot* slot = editSlots + (editHead & (EDIT_QUEUE_CAPACITY-1));
+	return atomic_load_explicit(&slot->sequence, memory_order_acquire) == editHead+1;
+}
+
+int applyCellEdits(void (*setCell)(int row, int col, int state)) {
+	int numApplied = 0;
+	while (1) {
+		EditSlot* slot = editSlots + (editHead & (EDIT_QUEUE_CAPACITY-1));
+		if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != editHead+1)
+			break;
+		CellEdit edit = slot->edit;
+		atomic_store_explicit(&slot->sequence, editHead + EDIT_QUEUE_CAPACITY, memory_order_release);
+		editHead++;
+
+		if (edit.kind == EDIT_STAMP)
+			stampPattern(&edit, setCell);
+		else
+			paintStroke(&edit, edit.kind == EDIT_PAINT, setCell);
+		numApplied++;
+	}
+	return numApplied;
+}
+
+int numStampPatterns(void) {
+	return NUM_STAMP_PATTERNS;
+}
+
+const char* stampPatternName(int pattern) {
+	return STAMP_PATTERN[pattern].name;
+}
+
+int findStampPattern(const char* name) {
+	for (int k=0; k<NUM_STAMP_PATTERNS; k++) {
+		if (strcmp(name, STAMP_PATTERN[k].name) == 0)
+			return k;
+	}
+	return -1;
+}
@@ -0,0 +1,61 @@
+//
+//  cellEdits.h
+//  Cellular Automaton
+//
+//  Cells drawn, erased or stamped with the mouse (or the paint, erase &
+//  stamp commands) while the simulation runs.  Each mouse event pushes one
+//  edit into a bounded lock-free queue, and the thread that completes a
+//  generation applies all the waiting edits to the current grid, between
+//  two generations: they show up in the next generation, and the workers
+//  never wait for the front end.  A full queue drops the edit.
+//
+
+#ifndef CELL_EDITS_H
+#define CELL_EDITS_H
+
+//	must be a power of 2
+#define EDIT_QUEUE_CAPACITY		4096
+#define MAX_BRUSH_RADIUS		32
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef enum EditKind {
+	//	the brush (a disc) along a stroke, setting cells alive or dead
+	EDIT_PAINT = 0,
+	EDIT_ERASE,
+	//	a pattern centered on the cell
+	EDIT_STAMP
+} EditKind;
+
+typedef struct CellEdit {
+	EditKind kind;
+	//	a stroke goes from (row, col) to (toRow, toCol); a stamp is at (row, col)
+	int row, col;
+	int toRow, toCol;
+	//	brush radius (0: one cell), or index of the stamp's pattern
+	int size;
+} CellEdit;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void initializeEditQueue(void);
+//	Any thread may push; returns 0 if the queue is full (the edit is dropped)
+int pushCellEdit(const CellEdit* edit);
+//	1 if an edit is waiting
+int editPending(void);
+//	Only the thread completing a generation: takes every waiting edit out of
+//	the queue and calls setCell for each cell it covers (row & col may be
+//	out of the grid).  Returns the number of edits applied.
+int applyCellEdits(void (*setCell)(int row, int col, int state));
+
+//	Patterns that can be stamped
+int numStampPatterns(void);
+const char* stampPatternName(int pattern);
+//	-1 if no pattern has that name
+int findStampPattern(const char* name);
+
+#endif // CELL_EDITS_H
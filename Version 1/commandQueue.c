@@ -0,0 +1,132 @@
+//
+//  commandQueue.c
+//  Cellular Automaton
+//
+//  Array-based multi-producer queue (D. Vyukov's bounded MPMC design): each
+//  slot carries a sequence number telling producers and the consumer whose
+//  turn it is, so nobody ever takes a lock.
+//
+
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "commandQueue.h"
+
+//---------------------------------------------------------------------------
+//  Private data types
+//---------------------------------------------------------------------------
+
+typedef struct CommandSlot {
+	atomic_size_t sequence;
+	char text[COMMAND_LENGTH];
+} CommandSlot;
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+CommandSlot commandSlots[COMMAND_QUEUE_CAPACITY];
+//	producers and consumer live on separate cache lines
+_Alignas(64) atomic_size_t commandTail;
+_Alignas(64) atomic_size_t commandHead;
+
+//	threads in waitForCommands()
+atomic_int numCommandWaiters = 0;
+pthread_mutex_t commandWaitLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t commandArrived = PTHREAD_COND_INITIALIZER;
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void initializeCommandQueue(void) {
+	for (size_t k=0; k<COMMAND_QUEUE_CAPACITY; k++)
+		atomic_store_explicit(&commandSlots[k].sequence, k, memory_order_relaxed);
+	atomic_store(&commandTail, 0);
+	atomic_store(&commandHead, 0);
+}
+
+int pushCommand(const char* command) {
+	size_t pos = atomic_load_explicit(&commandTail, memory_order_relaxed);
+	CommandSlot* slot;
+
+	while (1) {
+		slot = commandSlots + (pos & (COMMAND_QUEUE_CAPACITY-1));
+		size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		long diff = (long) seq - (long) pos;
+		if (diff == 0) {
+			//	slot is free: try to claim it
+			if (atomic_compare_exchange_weak_explicit(&commandTail, &pos, pos+1,
+													  memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		//	the consumer has not freed this slot yet --> queue is full
+		else if (diff < 0)
+			return 0;
+		else
+			pos = atomic_load_explicit(&commandTail, memory_order_relaxed);
+	}
+
+	strncpy(slot->text, command, COMMAND_LENGTH-1);
+	slot->text[COMMAND_LENGTH-1] = '\0';
+	atomic_store_explicit(&slot->sequence, pos+1, memory_order_release);
+	wakeCommandWaiters();
+	return 1;
+}
+
+int popCommand(char* command) {
+	size_t pos = atomic_load_explicit(&commandHead, memory_order_relaxed);
+	CommandSlot* slot;
+
+	while (1) {
+		slot = commandSlots + (pos & (COMMAND_QUEUE_CAPACITY-1));
+		size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		long diff = (long) seq - (long) (pos+1);
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&commandHead, &pos, pos+1,
+													  memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		//	nothing published in this slot yet --> queue is empty
+		else if (diff < 0)
+			return 0;
+		else
+			pos = atomic_load_explicit(&commandHead, memory_order_relaxed);
+	}
+
+	memcpy(command, slot->text, COMMAND_LENGTH);
+	atomic_store_explicit(&slot->sequence, pos + COMMAND_QUEUE_CAPACITY, memory_order_release);
+	return 1;
+}
+
+int commandPending(void) {
+	size_t pos = atomic_load_explicit(&commandHead, memory_order_relaxed);
+	CommandSlot* slot = commandSlots + (pos & (COMMAND_QUEUE_CAPACITY-1));
+	return atomic_load_explicit(&slot->sequence, memory_order_acquire) == pos+1;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	The waiter counts itself before it checks ready(), and a pusher checks
+ *	the count after it published: one of them sees the other (both go
+ *	through a full fence), so a wake-up is never lost, and pushers that
+ *	see no waiter take no lock.
+ *---------------------------------------------------------------------------
+ */
+void waitForCommands(int (*ready)(void)) {
+	pthread_mutex_lock(&commandWaitLock);
+	atomic_fetch_add(&numCommandWaiters, 1);
+	while (!ready())
+		pthread_cond_wait(&commandArrived, &commandWaitLock);
+	atomic_fetch_sub(&numCommandWaiters, 1);
+	pthread_mutex_unlock(&commandWaitLock);
+}
+
+void wakeCommandWaiters(void) {
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load(&numCommandWaiters) == 0)
+		return;
+	pthread_mutex_lock(&commandWaitLock);
+	pthread_cond_broadcast(&commandArrived);
+	pthread_mutex_unlock(&commandWaitLock);
+}
@@ -0,0 +1,35 @@
+//
+//  commandQueue.h
+//  Cellular Automaton
+//
+//  Bounded lock-free queue of text commands.  Any thread (pipe server,
+//  control socket, ...) may push; the commands are applied by the thread
+//  that completes a generation, so they always take effect between two
+//  generations.
+//
+
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#define COMMAND_LENGTH			64
+//	must be a power of 2
+#define COMMAND_QUEUE_CAPACITY	4096
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void initializeCommandQueue(void);
+//	returns 0 if the queue is full (the command is not queued)
+int pushCommand(const char* command);
+//	returns 0 if the queue is empty
+int popCommand(char* command);
+//	1 if a command is waiting (without taking it out of the queue)
+int commandPending(void);
+//	Sleeps until ready() returns 1, checking again each time a command is
+//	pushed or wakeCommandWaiters() is called (for input that comes through
+//	other queues).  Pushing only takes a lock while a thread is waiting.
+void waitForCommands(int (*ready)(void));
+void wakeCommandWaiters(void);
+
+#endif // COMMAND_QUEUE_H
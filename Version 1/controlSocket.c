@@ -0,0 +1,171 @@
+//
+//  controlSocket.c
+//  Cellular Automaton
+//
+//  A single thread polls the listening socket and all connected clients.
+//  Queries are answered from values the simulation publishes, and commands
+//  go through the same queue as the named pipe, so serving a client never
+//  makes the worker threads wait.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "commandQueue.h"
+#include "controlSocket.h"
+
+#define MAX_CLIENTS		16
+#define REPLY_LENGTH	4096
+
+//---------------------------------------------------------------------------
+//  Private data types & functions' prototypes
+//---------------------------------------------------------------------------
+
+typedef struct Client {
+	int fd;
+	char line[COMMAND_LENGTH];
+	int lineLength;
+} Client;
+
+int openControlSocket(void);
+int handleClientData(Client* client);
+void handleClientLine(Client* client);
+void sendReply(Client* client, const char* reply);
+
+//---------------------------------------------------------------------------
+//	Server thread
+//---------------------------------------------------------------------------
+
+void* controlSocketServer(void* arg) {
+	(void) arg;
+	int listenFD = openControlSocket();
+	if (listenFD < 0)
+		return NULL;
+
+	Client clients[MAX_CLIENTS];
+	int numClients = 0;
+	struct pollfd polled[MAX_CLIENTS+1];
+
+	while (1) {
+		polled[0].fd = listenFD;
+		polled[0].events = POLLIN;
+		for (int k=0; k<numClients; k++) {
+			polled[k+1].fd = clients[k].fd;
+			polled[k+1].events = POLLIN;
+		}
+
+		if (poll(polled, numClients+1, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		//	serve the clients first, since accepting changes the client list
+		for (int k=numClients-1; k>=0; k--) {
+			if (polled[k+1].revents == 0)
+				continue;
+			if (!handleClientData(clients + k)) {
+				close(clients[k].fd);
+				clients[k] = clients[--numClients];
+			}
+		}
+
+		if (polled[0].revents & POLLIN) {
+			int fd = accept(listenFD, NULL, NULL);
+			if (fd >= 0) {
+				if (numClients < MAX_CLIENTS) {
+					clients[numClients].fd = fd;
+					clients[numClients].lineLength = 0;
+					numClients++;
+				}
+				else
+					close(fd);
+			}
+		}
+	}
+
+	close(listenFD);
+	return NULL;
+}
+
+int openControlSocket(void) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, CONTROL_SOCKET_PATH, sizeof(address.sun_path)-1);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		printf("could not create control socket\n");
+		return -1;
+	}
+	//	left over by a previous run
+	unlink(CONTROL_SOCKET_PATH);
+	if (bind(fd, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(fd, 4) < 0) {
+		printf("could not bind control socket %s\n", CONTROL_SOCKET_PATH);
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Reads what the client sent and handles every complete line.
+ *	Returns 0 when the client has disconnected.
+ *---------------------------------------------------------------------------
+ */
+int handleClientData(Client* client) {
+	char buffer[4096];
+	ssize_t numRead = read(client->fd, buffer, sizeof(buffer));
+	if (numRead <= 0)
+		return numRead < 0 && (errno == EINTR || errno == EAGAIN);
+
+	for (ssize_t k=0; k<numRead; k++) {
+		if (buffer[k] == '\n') {
+			client->line[client->lineLength] = '\0';
+			//	tolerate clients sending \r\n
+			if (client->lineLength > 0 && client->line[client->lineLength-1] == '\r')
+				client->line[client->lineLength-1] = '\0';
+			handleClientLine(client);
+			client->lineLength = 0;
+		}
+		else if (client->lineLength < COMMAND_LENGTH-1)
+			client->line[client->lineLength++] = buffer[k];
+	}
+	return 1;
+}
+
+void handleClientLine(Client* client) {
+	char reply[REPLY_LENGTH];
+
+	if (client->line[0] == '\0')
+		return;
+
+	if (!queryToJSON(client->line, reply, sizeof(reply))) {
+		//	echo the command back, minus anything that would break the JSON
+		char echoed[COMMAND_LENGTH];
+		int n = 0;
+		for (int k=0; client->line[k] != '\0'; k++)
+			if (client->line[k] != '"' && client->line[k] != '\\' && client->line[k] >= ' ')
+				echoed[n++] = client->line[k];
+		echoed[n] = '\0';
+
+		if (pushCommand(client->line))
+			snprintf(reply, sizeof(reply), "{\"ok\":true,\"queued\":\"%s\"}", echoed);
+		else
+			snprintf(reply, sizeof(reply), "{\"ok\":false,\"error\":\"command queue full\"}");
+	}
+	sendReply(client, reply);
+}
+
+void sendReply(Client* client, const char* reply) {
+	size_t length = strlen(reply);
+	//	MSG_NOSIGNAL: a client that went away must not kill the process
+	send(client->fd, reply, length, MSG_NOSIGNAL);
+	send(client->fd, "\n", 1, MSG_NOSIGNAL);
+}
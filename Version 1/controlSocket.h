@@ -0,0 +1,26 @@
+//
+//  controlSocket.h
+//  Cellular Automaton
+//
+//  Unix domain socket control interface.  Clients send one command or query
+//  per line and get one line of JSON back for each.
+//
+
+#ifndef CONTROL_SOCKET_H
+#define CONTROL_SOCKET_H
+
+#include <stddef.h>
+
+#define CONTROL_SOCKET_PATH		"/tmp/cellSocket"
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void* controlSocketServer(void* arg);
+
+//	Implemented in main.c: writes the JSON answer to a query into reply and
+//	returns 1, or returns 0 if the line is not a query (then it is a command)
+int queryToJSON(const char* query, char* reply, size_t replySize);
+
+#endif // CONTROL_SOCKET_H
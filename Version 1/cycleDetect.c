@@ -0,0 +1,86 @@
+//
+//  cycleDetect.c
+//  Cellular Automaton
+//
+//  Only called by the thread completing a generation, so no locking here;
+//  other threads read the result through currentCycle(), whose fields are
+//  single words.
+//
+
+#include <string.h>
+#include "cycleDetect.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+const char* CYCLE_ACTION_NAME[] = {"log", "stop", "park", "reset"};
+
+uint64_t hashHistory[CYCLE_HISTORY_SIZE];
+unsigned long historyGeneration[CYCLE_HISTORY_SIZE];
+unsigned int historyLength = 0;
+unsigned int historyNext = 0;
+
+CycleInfo detectedCycle = {0, 0};
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+/*
+ *---------------------------------------------------------------------------
+ *	Scans the history from the most recent entry, so we report the
+ *	smallest period (a period-2 oscillator also repeats every 4).  With
+ *	64-bit hashes a false match is too unlikely to bother confirming it.
+ *---------------------------------------------------------------------------
+ */
+unsigned int recordGenerationHash(uint64_t hash, unsigned long generation) {
+	unsigned int period = 0;
+	for (unsigned int k=1; k<=historyLength; k++) {
+		unsigned int slot = (historyNext + CYCLE_HISTORY_SIZE - k) % CYCLE_HISTORY_SIZE;
+		if (hashHistory[slot] == hash) {
+			period = (unsigned int) (generation - historyGeneration[slot]);
+			break;
+		}
+	}
+
+	hashHistory[historyNext] = hash;
+	historyGeneration[historyNext] = generation;
+	historyNext = (historyNext + 1) % CYCLE_HISTORY_SIZE;
+	if (historyLength < CYCLE_HISTORY_SIZE)
+		historyLength++;
+
+	//	only report the cycle once, when we first run into it
+	if (period > 0 && detectedCycle.period == 0) {
+		detectedCycle.detectedAt = generation;
+		detectedCycle.period = period;
+		return period;
+	}
+	if (period == 0)
+		detectedCycle.period = 0;
+	return 0;
+}
+
+void clearCycleHistory(void) {
+	historyLength = 0;
+	historyNext = 0;
+	detectedCycle.period = 0;
+}
+
+CycleInfo currentCycle(void) {
+	return detectedCycle;
+}
+
+int parseCycleAction(const char* name, CycleAction* action) {
+	for (int k=CYCLE_LOG; k<=CYCLE_RESET; k++) {
+		if (strcmp(name, CYCLE_ACTION_NAME[k]) == 0) {
+			*action = (CycleAction) k;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+const char* cycleActionName(CycleAction action) {
+	return CYCLE_ACTION_NAME[action];
+}
@@ -0,0 +1,51 @@
+//
+//  cycleDetect.h
+//  Cellular Automaton
+//
+//  Detects that the grid went back to a state it was in a few generations
+//  earlier (still life, oscillator, or dead grid), by comparing the hash of
+//  each generation with a short history of previous hashes.
+//
+
+#ifndef CYCLE_DETECT_H
+#define CYCLE_DETECT_H
+
+#include <stdint.h>
+
+//	longest period that can be detected
+#define CYCLE_HISTORY_SIZE	256
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef enum CycleAction {
+	CYCLE_LOG = 0,		//	print period & generation, keep going
+	CYCLE_STOP,			//	exit the application
+	CYCLE_PARK,			//	stop computing until a command changes something
+	CYCLE_RESET			//	start again from a new random grid
+} CycleAction;
+
+typedef struct CycleInfo {
+	//	0 while no cycle has been found
+	unsigned int period;
+	//	generation at which the cycle was detected
+	unsigned long detectedAt;
+} CycleInfo;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	Records the hash of a generation; returns the period if the grid has been
+//	in the same state within the last CYCLE_HISTORY_SIZE generations, else 0
+unsigned int recordGenerationHash(uint64_t hash, unsigned long generation);
+//	Forgets the history (after a reset, a rule change, edits...)
+void clearCycleHistory(void);
+CycleInfo currentCycle(void);
+
+//	parses "log", "stop", "park" or "reset"; returns 0 if the name is unknown
+int parseCycleAction(const char* name, CycleAction* action);
+const char* cycleActionName(CycleAction action);
+
+#endif // CYCLE_DETECT_H
@@ -0,0 +1,176 @@
+//
+//  ensemble.c
+//  Cellular Automaton
+//
+//  Each worker owns one engine, sized for the largest grid, and runs one
+//  whole grid at a time: a small grid stays in the worker's cache for all
+//  its generations.  Workers take the next job from a shared counter, the
+//  most expensive jobs first so that no long job is left for the end.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ensemble.h"
+#include "lifeEngine.h"
+#include "perfCounters.h"
+
+//---------------------------------------------------------------------------
+//  Private data types
+//---------------------------------------------------------------------------
+
+typedef struct EnsembleJob {
+	//	line in the job file
+	int line;
+	LifeRule rule;
+	int rows, cols;
+	unsigned long long seed;
+	unsigned long generations;
+	Boundary boundary;
+} EnsembleJob;
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+EnsembleJob* jobs = NULL;
+int numJobs = 0;
+int maxJobRows = 0, maxJobCols = 0;
+//	order in which the jobs are handed out
+int* jobOrder = NULL;
+atomic_int nextJob = 0;
+
+FILE* resultsCSV = NULL;
+pthread_mutex_t resultsLock = PTHREAD_MUTEX_INITIALIZER;
+//	generations actually computed times cells, for the throughput
+atomic_ullong cellsComputed = 0;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+int readJobs(const char* path) {
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "could not open %s\n", path);
+		return 0;
+	}
+	int capacity = 64;
+	jobs = (EnsembleJob*) malloc(capacity * sizeof(EnsembleJob));
+	char line[256], ruleText[64], boundaryText[16];
+	int lineNumber = 0, ok = 1;
+	while (ok && fgets(line, sizeof(line), file) != NULL) {
+		lineNumber++;
+		char* start = line + strspn(line, " \t");
+		if (*start == '#' || *start == '\n' || *start == '\0')
+			continue;
+
+		if (numJobs == capacity) {
+			capacity *= 2;
+			jobs = (EnsembleJob*) realloc(jobs, capacity * sizeof(EnsembleJob));
+		}
+		EnsembleJob* job = jobs + numJobs;
+		job->line = lineNumber;
+		ok = sscanf(start, "%63s %d %d %llu %lu %15s", ruleText, &job->rows, &job->cols,
+					&job->seed, &job->generations, boundaryText) == 6 &&
+			 parseRule(ruleText, &job->rule) && parseBoundary(boundaryText, &job->boundary) &&
+			 job->rows >= 3 && job->cols >= 3;
+		if (!ok) {
+			fprintf(stderr, "%s, line %d: expected rule rows cols seed generations dead|wrap\n",
+					path, lineNumber);
+			break;
+		}
+		if (job->rows > maxJobRows)
+			maxJobRows = job->rows;
+		if (job->cols > maxJobCols)
+			maxJobCols = job->cols;
+		numJobs++;
+	}
+	fclose(file);
+	return ok;
+}
+
+int compareCost(const void* a, const void* b) {
+	const EnsembleJob* jobA = jobs + *(const int*) a;
+	const EnsembleJob* jobB = jobs + *(const int*) b;
+	double costA = (double) jobA->rows * jobA->cols * jobA->generations;
+	double costB = (double) jobB->rows * jobB->cols * jobB->generations;
+	return (costA < costB) - (costA > costB);
+}
+
+void* ensembleWorker(void* arg) {
+	(void) arg;
+	LifeEngine engine;
+	if (!createEngine(&engine, maxJobRows, maxJobCols)) {
+		fprintf(stderr, "could not allocate an engine\n");
+		exit(-1);
+	}
+	char name[RULE_NAME_LENGTH];
+	int k;
+	while ((k = atomic_fetch_add(&nextJob, 1)) < numJobs) {
+		const EnsembleJob* job = jobs + jobOrder[k];
+		startEngine(&engine, job->rows, job->cols, job->rule, job->boundary, job->seed);
+		engineRun(&engine, job->generations);
+
+		//	with a cycle found, not all generations were computed
+		unsigned long computed = engine.period > 0 ?
+			engine.periodFoundAt + (job->generations - engine.periodFoundAt) % engine.period :
+			job->generations;
+		atomic_fetch_add(&cellsComputed, (unsigned long long) computed * job->rows * job->cols);
+
+		ruleName(job->rule, name);
+		pthread_mutex_lock(&resultsLock);
+		fprintf(resultsCSV, "%d,%s,%d,%d,%llu,%lu,%s,%lu,%u,%lu,%016llx\n", job->line, name,
+				job->rows, job->cols, job->seed, job->generations, boundaryName(job->boundary),
+				engine.population, engine.period, engine.periodFoundAt,
+				(unsigned long long) engine.hash);
+		pthread_mutex_unlock(&resultsLock);
+	}
+	destroyEngine(&engine);
+	return NULL;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int runEnsemble(int argc, char** argv) {
+	int numWorkers = 0;
+	if (argc != 3 || sscanf(argv[2], "%d", &numWorkers) != 1 || numWorkers < 1) {
+		fprintf(stderr, "usage: cell -ensemble jobFile results.csv numThreads\n");
+		return -1;
+	}
+	if (!readJobs(argv[0]))
+		return -1;
+	resultsCSV = fopen(argv[1], "w");
+	if (resultsCSV == NULL) {
+		fprintf(stderr, "could not create %s\n", argv[1]);
+		return -1;
+	}
+	fprintf(resultsCSV, "line,rule,rows,cols,seed,generations,boundary,population,period,periodFoundAt,hash\n");
+
+	jobOrder = (int*) malloc(numJobs * sizeof(int));
+	for (int k=0; k<numJobs; k++)
+		jobOrder[k] = k;
+	qsort(jobOrder, numJobs, sizeof(int), compareCost);
+
+	if (numWorkers > numJobs)
+		numWorkers = numJobs > 0 ? numJobs : 1;
+	pthread_t* workers = (pthread_t*) malloc(numWorkers * sizeof(pthread_t));
+	uint64_t start = perfNow();
+	for (int k=0; k<numWorkers; k++)
+		pthread_create(workers + k, NULL, ensembleWorker, NULL);
+	for (int k=0; k<numWorkers; k++)
+		pthread_join(workers[k], NULL);
+	double seconds = 1e-9 * (perfNow() - start);
+
+	fclose(resultsCSV);
+	fprintf(stderr, "%d grids in %.3f s: %.1f grids/sec, %.1f Mcells/sec (%d threads)\n",
+			numJobs, seconds, numJobs / seconds, 1e-6 * cellsComputed / seconds, numWorkers);
+	free(workers);
+	free(jobOrder);
+	free(jobs);
+	return 0;
+}
@@ -0,0 +1,25 @@
+//
+//  ensemble.h
+//  Cellular Automaton
+//
+//  Batch mode for parameter sweeps: runs many small independent grids
+//  listed in a job file, without window, pipe or socket, and writes one
+//  line of results per grid to a CSV file.
+//
+//  Job file: one grid per line, blank lines and lines starting with # are
+//  skipped:
+//		rule rows cols seed generations boundary
+//		B3/S23 256 256 17 1000 wrap
+//
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	argv: job file, results CSV file, number of threads.  Returns the exit code
+int runEnsemble(int argc, char** argv);
+
+#endif // ENSEMBLE_H
@@ -0,0 +1,658 @@
+//
+//  frameExport.c
+//  Cellular Automaton
+//
+//  The simulation only takes a snapshot of the cell states (one byte per cell)
+//  into a preallocated frame slot, and the worker threads copy their own rows
+//  of it while they compute the next generation, rather than one thread copying
+//  the whole grid while the others wait at the barrier.  Converting the cells
+//  to colors and encoding the images is done by a small pool of encoder
+//  threads, so writing frames never slows down the worker threads.  When every
+//  slot is busy the frame is dropped (and counted) rather than making the
+//  simulation wait.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "gl_frontEnd.h"
+#include "frameExport.h"
+
+//	deflate: matches of 3 to 258 bytes, up to 32 KB back
+#define MIN_MATCH		3
+#define MAX_MATCH		258
+#define WINDOW_SIZE		32768
+#define HASH_BITS		15
+
+//---------------------------------------------------------------------------
+//  Defined in gl_frontEnd.c
+//---------------------------------------------------------------------------
+
+extern GLfloat cellColor[MAX_CELL_STATES][4];
+
+//---------------------------------------------------------------------------
+//  Private data types & functions' prototypes
+//---------------------------------------------------------------------------
+
+typedef struct FrameSlot {
+	unsigned char* cells;
+	unsigned long generation;
+	//	order in which the frames were captured (for the raw stream)
+	unsigned long sequence;
+} FrameSlot;
+
+typedef struct Encoder {
+	pthread_t threadID;
+	//	PPM & raw stream
+	unsigned char* rgb;
+	//	PNG: palette index of each pixel, after the filter byte of its line,
+	//	the zlib stream, and the last position of each 3-byte hash
+	unsigned char* scanlines;
+	unsigned char* zlibData;
+	int32_t* matchHead;
+} Encoder;
+
+//	Bits of a deflate stream, first bit in the lowest bit of each byte
+typedef struct BitWriter {
+	unsigned char* out;
+	size_t n;
+	uint64_t bits;
+	unsigned int count;
+} BitWriter;
+
+int reserveSlot(void);
+void copyRows(FrameSlot* frame, const Grid* grid, int firstRow, int endRow);
+void queueFrame(unsigned int slot);
+void* encoderFunc(void* arg);
+void encodeFrame(Encoder* encoder, const FrameSlot* frame);
+void writeRawFrame(const unsigned char* rgb, unsigned long sequence);
+int writePPM(const char* path, const unsigned char* rgb);
+int writePNG(const char* path, Encoder* encoder, const FrameSlot* frame);
+size_t deflateFixed(Encoder* encoder, const unsigned char* data, size_t size, size_t lineSize);
+void putBits(BitWriter* writer, uint32_t value, unsigned int numBits);
+size_t matchLength(const unsigned char* earlier, const unsigned char* here, size_t limit);
+void initializeDeflateTables(void);
+void writeChunk(FILE* fp, const char* type, const unsigned char* data, size_t length);
+uint32_t crc32Update(uint32_t crc, const unsigned char* data, size_t length);
+uint32_t adler32(const unsigned char* data, size_t length);
+void putBigEndian32(unsigned char* dest, uint32_t value);
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+ExportSettings exportSettings;
+int exportEnabled = 0;
+
+unsigned int frameRows, frameCols;
+unsigned int imageWidth, imageHeight;
+
+//	palette converted once from the GL colors
+unsigned char paletteRGB[MAX_CELL_STATES][3];
+
+FrameSlot* frameSlots;
+unsigned int numFrameSlots;
+//	queues of slot indices: free slots and frames waiting for an encoder
+unsigned int *freeSlots, *readySlots;
+unsigned int numFreeSlots, readyHead, readyCount;
+
+//	slot the workers are copying their rows into (-1 --> none), only set at
+//	the barrier, and number of rows copied so far
+int scheduledSlot = -1;
+atomic_uint scheduledRows;
+
+Encoder* encoders;
+
+unsigned long nextCaptureSequence = 0;
+unsigned long nextRawSequence = 0;
+unsigned long droppedFrames = 0;
+int stopEncoders = 0;
+
+pthread_mutex_t exportLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t frameReady = PTHREAD_COND_INITIALIZER;
+pthread_cond_t rawTurn = PTHREAD_COND_INITIALIZER;
+
+uint32_t crcTable[256];
+
+//	fixed Huffman codes of the literals & lengths (already bit-reversed) and
+//	their number of bits, then the symbols of the match lengths & distances
+uint16_t literalCode[288];
+unsigned char literalBits[288];
+unsigned char lengthSymbol[MAX_MATCH+1];
+//	distances 1 - 256, then (distance-1) >> 7 for the larger ones
+unsigned char distanceSymbol[512];
+const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+								  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const unsigned char LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+										3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+									257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+									8193, 12289, 16385, 24577};
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+/*
+ *---------------------------------------------------------------------------
+ *	Allocates all frame slots & encoder buffers up front and launches the
+ *	encoder threads.
+ *---------------------------------------------------------------------------
+ */
+void initializeExport(const ExportSettings* settings, unsigned int numRows, unsigned int numCols) {
+	if (settings->interval == 0)
+		return;
+
+	exportSettings = *settings;
+	if (exportSettings.scale == 0)
+		exportSettings.scale = 1;
+	if (exportSettings.numEncoders == 0)
+		exportSettings.numEncoders = 1;
+	if (exportSettings.directory == NULL)
+		exportSettings.directory = ".";
+
+	frameRows = numRows;
+	frameCols = numCols;
+	imageWidth = numCols * exportSettings.scale;
+	imageHeight = numRows * exportSettings.scale;
+
+	for (int k=0; k<MAX_CELL_STATES; k++)
+		for (int c=0; c<3; c++)
+			paletteRGB[k][c] = (unsigned char) (255.f * cellColor[k][c] + 0.5f);
+
+	for (uint32_t n=0; n<256; n++) {
+		uint32_t c = n;
+		for (int k=0; k<8; k++)
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		crcTable[n] = c;
+	}
+	initializeDeflateTables();
+
+	//	two slots per encoder lets the simulation run ahead while frames encode
+	numFrameSlots = 2*exportSettings.numEncoders + 2;
+	frameSlots = (FrameSlot*) calloc(numFrameSlots, sizeof(FrameSlot));
+	freeSlots = (unsigned int*) malloc(numFrameSlots*sizeof(unsigned int));
+	readySlots = (unsigned int*) malloc(numFrameSlots*sizeof(unsigned int));
+	for (unsigned int k=0; k<numFrameSlots; k++) {
+		frameSlots[k].cells = (unsigned char*) malloc((size_t) numRows*numCols);
+		freeSlots[k] = k;
+	}
+	numFreeSlots = numFrameSlots;
+	readyHead = readyCount = 0;
+
+	//	a PNG scanline is one filter byte followed by the pixels' palette
+	//	indices.  In the worst case every byte is a 9-bit literal.
+	size_t rawSize = (size_t) imageHeight * (1 + (size_t) imageWidth);
+	size_t zlibSize = 2 + rawSize + rawSize/8 + 8 + 4;
+	int needRGB = (exportSettings.format == EXPORT_PPM) || exportSettings.rawStdout;
+	int needPNG = (exportSettings.format == EXPORT_PNG) && !exportSettings.noFiles;
+	encoders = (Encoder*) calloc(exportSettings.numEncoders, sizeof(Encoder));
+	for (unsigned int k=0; k<exportSettings.numEncoders; k++) {
+		if (needRGB)
+			encoders[k].rgb = (unsigned char*) malloc(3*(size_t) imageWidth*imageHeight);
+		if (needPNG) {
+			encoders[k].scanlines = (unsigned char*) malloc(rawSize);
+			encoders[k].zlibData = (unsigned char*) malloc(zlibSize);
+			encoders[k].matchHead = (int32_t*) malloc((1 << HASH_BITS)*sizeof(int32_t));
+		}
+		if (pthread_create(&encoders[k].threadID, NULL, encoderFunc, encoders + k) != 0) {
+			printf("Could not create encoder thread\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	exportEnabled = 1;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Called once per generation by the thread that completes it, while the
+ *	other threads go on.  Only copies the cells; never waits for an encoder.
+ *---------------------------------------------------------------------------
+ */
+void exportGeneration(const Grid* grid, unsigned long generation) {
+	if (!exportEnabled || generation % exportSettings.interval != 0)
+		return;
+
+	int slot = reserveSlot();
+	if (slot < 0)
+		return;
+	//	the slot is ours until we put it in the ready queue
+	frameSlots[slot].generation = generation;
+	copyRows(frameSlots + slot, grid, 0, (int) frameRows);
+	queueFrame((unsigned int) slot);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Called once per generation at the barrier, so scheduledSlot only changes
+ *	while no worker reads it
+ *---------------------------------------------------------------------------
+ */
+void scheduleExport(unsigned long generation) {
+	scheduledSlot = -1;
+	if (!exportEnabled || generation % exportSettings.interval != 0)
+		return;
+
+	scheduledSlot = reserveSlot();
+	if (scheduledSlot >= 0) {
+		frameSlots[scheduledSlot].generation = generation;
+		atomic_store(&scheduledRows, 0);
+	}
+}
+
+void exportRows(const Grid* grid, int firstRow, int endRow) {
+	int slot = scheduledSlot;
+	if (slot < 0 || firstRow >= endRow)
+		return;
+
+	copyRows(frameSlots + slot, grid, firstRow, endRow);
+	unsigned int copied = (unsigned int) (endRow - firstRow);
+	if (atomic_fetch_add(&scheduledRows, copied) + copied == frameRows)
+		queueFrame((unsigned int) slot);
+}
+
+void flushScheduledExport(const Grid* grid) {
+	if (scheduledSlot < 0 || atomic_load(&scheduledRows) != 0)
+		return;
+	exportRows(grid, 0, (int) frameRows);
+	scheduledSlot = -1;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Lets the encoders finish all the frames already captured, then
+ *	terminates them.  Safe to call more than once.
+ *---------------------------------------------------------------------------
+ */
+void shutdownExport(void) {
+	if (!exportEnabled)
+		return;
+	exportEnabled = 0;
+
+	pthread_mutex_lock(&exportLock);
+	stopEncoders = 1;
+	pthread_cond_broadcast(&frameReady);
+	pthread_mutex_unlock(&exportLock);
+
+	for (unsigned int k=0; k<exportSettings.numEncoders; k++)
+		pthread_join(encoders[k].threadID, NULL);
+
+	if (exportSettings.rawStdout)
+		fflush(stdout);
+	if (droppedFrames > 0)
+		fprintf(stderr, "frame export: %lu frames dropped (encoders too slow)\n", droppedFrames);
+}
+
+unsigned long exportDroppedFrames(void) {
+	return droppedFrames;
+}
+
+//---------------------------------------------------------------------------
+//	Frame slots
+//---------------------------------------------------------------------------
+
+//	-1 (and the frame is counted as dropped) if every slot is busy
+int reserveSlot(void) {
+	pthread_mutex_lock(&exportLock);
+	if (numFreeSlots == 0) {
+		droppedFrames++;
+		pthread_mutex_unlock(&exportLock);
+		return -1;
+	}
+	unsigned int slot = freeSlots[--numFreeSlots];
+	pthread_mutex_unlock(&exportLock);
+	return (int) slot;
+}
+
+void copyRows(FrameSlot* frame, const Grid* grid, int firstRow, int endRow) {
+	for (int i=firstRow; i<endRow; i++) {
+		unsigned char* dest = frame->cells + (size_t) i*frameCols;
+		for (int b=0; b<grid->numBands; b++) {
+			const int* cells = grid->band[b][i];
+			for (int j=grid->firstCol[b]; j<grid->firstCol[b+1]; j++)
+				dest[j] = (unsigned char) cells[j];
+		}
+	}
+}
+
+void queueFrame(unsigned int slot) {
+	pthread_mutex_lock(&exportLock);
+	frameSlots[slot].sequence = nextCaptureSequence++;
+	readySlots[(readyHead + readyCount) % numFrameSlots] = slot;
+	readyCount++;
+	pthread_cond_signal(&frameReady);
+	pthread_mutex_unlock(&exportLock);
+}
+
+//---------------------------------------------------------------------------
+//	Encoder threads
+//---------------------------------------------------------------------------
+
+void* encoderFunc(void* arg) {
+	Encoder* encoder = (Encoder*) arg;
+
+	while (1) {
+		pthread_mutex_lock(&exportLock);
+		while (readyCount == 0 && !stopEncoders)
+			pthread_cond_wait(&frameReady, &exportLock);
+		if (readyCount == 0) {
+			pthread_mutex_unlock(&exportLock);
+			break;
+		}
+		unsigned int slot = readySlots[readyHead];
+		readyHead = (readyHead + 1) % numFrameSlots;
+		readyCount--;
+		pthread_mutex_unlock(&exportLock);
+
+		encodeFrame(encoder, frameSlots + slot);
+
+		pthread_mutex_lock(&exportLock);
+		freeSlots[numFreeSlots++] = slot;
+		pthread_mutex_unlock(&exportLock);
+	}
+	return NULL;
+}
+
+void encodeFrame(Encoder* encoder, const FrameSlot* frame) {
+	const unsigned int scale = exportSettings.scale;
+
+	//	expand the cells into RGB pixels, using the same palette as drawGrid().
+	//	OpenGL puts row 0 at the bottom of the pane while images go top to
+	//	bottom, so the rows are flipped to get the same picture as the window.
+	if (encoder->rgb != NULL) {
+		for (unsigned int i=0; i<frameRows; i++) {
+			const unsigned char* cells = frame->cells + (size_t) i*frameCols;
+			unsigned char* line = encoder->rgb + 3*(size_t) (frameRows-1-i)*scale*imageWidth;
+			unsigned char* pixel = line;
+			for (unsigned int j=0; j<frameCols; j++) {
+				const unsigned char* color = paletteRGB[cells[j] < MAX_CELL_STATES ? cells[j] : MAX_CELL_STATES-1];
+				for (unsigned int s=0; s<scale; s++) {
+					pixel[0] = color[0];
+					pixel[1] = color[1];
+					pixel[2] = color[2];
+					pixel += 3;
+				}
+			}
+			for (unsigned int s=1; s<scale; s++)
+				memcpy(line + 3*(size_t) s*imageWidth, line, 3*(size_t) imageWidth);
+		}
+	}
+
+	if (!exportSettings.noFiles) {
+		char path[1024];
+		snprintf(path, sizeof(path), "%s/frame_%08lu.%s", exportSettings.directory,
+				 frame->generation, exportSettings.format == EXPORT_PNG ? "png" : "ppm");
+		int ok = (exportSettings.format == EXPORT_PNG) ? writePNG(path, encoder, frame)
+													   : writePPM(path, encoder->rgb);
+		if (!ok)
+			fprintf(stderr, "frame export: could not write %s\n", path);
+	}
+
+	if (exportSettings.rawStdout)
+		writeRawFrame(encoder->rgb, frame->sequence);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Frames are encoded out of order by the pool, but a video encoder reading
+ *	the stream needs them in order, so each encoder waits for its turn.
+ *---------------------------------------------------------------------------
+ */
+void writeRawFrame(const unsigned char* rgb, unsigned long sequence) {
+	pthread_mutex_lock(&exportLock);
+	while (nextRawSequence != sequence)
+		pthread_cond_wait(&rawTurn, &exportLock);
+	pthread_mutex_unlock(&exportLock);
+
+	fwrite(rgb, 3, (size_t) imageWidth*imageHeight, stdout);
+
+	pthread_mutex_lock(&exportLock);
+	nextRawSequence++;
+	pthread_cond_broadcast(&rawTurn);
+	pthread_mutex_unlock(&exportLock);
+}
+
+//---------------------------------------------------------------------------
+//	Image writers
+//---------------------------------------------------------------------------
+
+int writePPM(const char* path, const unsigned char* rgb) {
+	FILE* fp = fopen(path, "wb");
+	if (fp == NULL)
+		return 0;
+	fprintf(fp, "P6\n%u %u\n255\n", imageWidth, imageHeight);
+	size_t written = fwrite(rgb, 3, (size_t) imageWidth*imageHeight, fp);
+	fclose(fp);
+	return written == (size_t) imageWidth*imageHeight;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Lossless PNG writer, without depending on zlib.  The pixels are indices
+ *	into the cell palette (one byte each), and go through a deflate encoder
+ *	with the fixed Huffman codes, which only looks for matches one pixel
+ *	back (runs of a state), one line back (a line like the one above, as
+ *	with every line of a scaled-up cell), and at the last place the same
+ *	3 bytes were seen.  That is enough for cell images, which are mostly
+ *	long runs of dead cells.
+ *---------------------------------------------------------------------------
+ */
+int writePNG(const char* path, Encoder* encoder, const FrameSlot* frame) {
+	static const unsigned char signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+	const unsigned int scale = exportSettings.scale;
+	const size_t lineSize = (size_t) imageWidth + 1;
+
+	//	one filter byte (0 = none) per line, then the pixels, rows flipped
+	//	as in encodeFrame()
+	for (unsigned int i=0; i<frameRows; i++) {
+		const unsigned char* cells = frame->cells + (size_t) i*frameCols;
+		unsigned char* line = encoder->scanlines + (size_t) (frameRows-1-i)*scale*lineSize;
+		unsigned char* pixel = line;
+		*pixel++ = 0;
+		for (unsigned int j=0; j<frameCols; j++) {
+			unsigned char index = cells[j] < MAX_CELL_STATES ? cells[j] : MAX_CELL_STATES-1;
+			for (unsigned int s=0; s<scale; s++)
+				*pixel++ = index;
+		}
+		for (unsigned int s=1; s<scale; s++)
+			memcpy(line + s*lineSize, line, lineSize);
+	}
+
+	FILE* fp = fopen(path, "wb");
+	if (fp == NULL)
+		return 0;
+	fwrite(signature, 1, 8, fp);
+
+	unsigned char header[13];
+	putBigEndian32(header, imageWidth);
+	putBigEndian32(header + 4, imageHeight);
+	header[8] = 8;		//	bit depth
+	header[9] = 3;		//	color type: palette
+	header[10] = 0;		//	compression
+	header[11] = 0;		//	filter
+	header[12] = 0;		//	no interlace
+	writeChunk(fp, "IHDR", header, 13);
+	writeChunk(fp, "PLTE", &paletteRGB[0][0], 3*MAX_CELL_STATES);
+
+	size_t n = deflateFixed(encoder, encoder->scanlines, imageHeight*lineSize, lineSize);
+	writeChunk(fp, "IDAT", encoder->zlibData, n);
+	writeChunk(fp, "IEND", NULL, 0);
+
+	int ok = !ferror(fp);
+	fclose(fp);
+	return ok;
+}
+
+void putBits(BitWriter* writer, uint32_t value, unsigned int numBits) {
+	writer->bits |= (uint64_t) value << writer->count;
+	writer->count += numBits;
+	while (writer->count >= 8) {
+		writer->out[writer->n++] = (unsigned char) writer->bits;
+		writer->bits >>= 8;
+		writer->count -= 8;
+	}
+}
+
+size_t matchLength(const unsigned char* earlier, const unsigned char* here, size_t limit) {
+	size_t length = 0;
+	while (length < limit && earlier[length] == here[length])
+		length++;
+	return length;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Writes the zlib stream of data (a single fixed-Huffman deflate block)
+ *	into the encoder's buffer and returns its size
+ *---------------------------------------------------------------------------
+ */
+size_t deflateFixed(Encoder* encoder, const unsigned char* data, size_t size, size_t lineSize) {
+	BitWriter writer = {encoder->zlibData, 0, 0, 0};
+	int32_t* head = encoder->matchHead;
+	memset(head, 0xFF, (1 << HASH_BITS)*sizeof(int32_t));
+
+	writer.out[writer.n++] = 0x78;
+	writer.out[writer.n++] = 0x01;
+	//	last block, fixed codes
+	putBits(&writer, 1, 1);
+	putBits(&writer, 1, 2);
+
+	size_t pos = 0;
+	while (pos < size) {
+		size_t bestLength = 0, bestDistance = 0;
+		if (size - pos >= MIN_MATCH) {
+			size_t limit = (size - pos < MAX_MATCH) ? size - pos : MAX_MATCH;
+			uint32_t hash = ((data[pos] << 16) | (data[pos+1] << 8) | data[pos+2]) * 2654435761u >> (32 - HASH_BITS);
+			size_t candidates[3] = {1, lineSize, pos - (size_t) head[hash]};
+			for (int k=0; k<3; k++) {
+				size_t distance = candidates[k];
+				if (k == 2 && head[hash] < 0)
+					break;
+				if (distance == 0 || distance > pos || distance > WINDOW_SIZE || distance == bestDistance)
+					continue;
+				size_t length = matchLength(data + pos - distance, data + pos, limit);
+				if (length > bestLength) {
+					bestLength = length;
+					bestDistance = distance;
+				}
+			}
+			head[hash] = (int32_t) pos;
+		}
+
+		if (bestLength < MIN_MATCH) {
+			putBits(&writer, literalCode[data[pos]], literalBits[data[pos]]);
+			pos++;
+			continue;
+		}
+		unsigned int symbol = lengthSymbol[bestLength];
+		putBits(&writer, literalCode[257 + symbol], literalBits[257 + symbol]);
+		putBits(&writer, (uint32_t) (bestLength - LENGTH_BASE[symbol]), LENGTH_EXTRA[symbol]);
+		symbol = (bestDistance <= 256) ? distanceSymbol[bestDistance - 1]
+									   : distanceSymbol[256 + ((bestDistance - 1) >> 7)];
+		//	(5-bit codes, bit-reversed)
+		uint32_t code = 0;
+		for (int b=0; b<5; b++)
+			code |= ((symbol >> b) & 1) << (4 - b);
+		putBits(&writer, code, 5);
+		unsigned int extra = (symbol < 4) ? 0 : symbol/2 - 1;
+		putBits(&writer, (uint32_t) (bestDistance - DISTANCE_BASE[symbol]), extra);
+		pos += bestLength;
+	}
+	//	end of block, then pad to a whole byte
+	putBits(&writer, literalCode[256], literalBits[256]);
+	if (writer.count > 0)
+		putBits(&writer, 0, 8 - writer.count);
+
+	putBigEndian32(writer.out + writer.n, adler32(data, size));
+	return writer.n + 4;
+}
+
+void initializeDeflateTables(void) {
+	for (unsigned int symbol=0; symbol<288; symbol++) {
+		uint32_t code;
+		unsigned int numBits;
+		if (symbol < 144) {
+			code = 0x30 + symbol;
+			numBits = 8;
+		} else if (symbol < 256) {
+			code = 0x190 + symbol - 144;
+			numBits = 9;
+		} else if (symbol < 280) {
+			code = symbol - 256;
+			numBits = 7;
+		} else {
+			code = 0xC0 + symbol - 280;
+			numBits = 8;
+		}
+		//	Huffman codes go out starting from their highest bit
+		uint32_t reversed = 0;
+		for (unsigned int b=0; b<numBits; b++)
+			reversed |= ((code >> b) & 1) << (numBits - 1 - b);
+		literalCode[symbol] = (uint16_t) reversed;
+		literalBits[symbol] = (unsigned char) numBits;
+	}
+
+	for (unsigned int symbol=0; symbol<29; symbol++) {
+		unsigned int end = (symbol < 28) ? LENGTH_BASE[symbol+1] : MAX_MATCH+1;
+		//	(258 has its own symbol, past the 5 extra bits of 227)
+		for (unsigned int length=LENGTH_BASE[symbol]; length<end && length<=MAX_MATCH; length++)
+			lengthSymbol[length] = (unsigned char) symbol;
+	}
+
+	for (unsigned int symbol=0; symbol<30; symbol++) {
+		unsigned int end = (symbol < 29) ? DISTANCE_BASE[symbol+1] : WINDOW_SIZE+1;
+		for (unsigned int distance=DISTANCE_BASE[symbol]; distance<end; distance++) {
+			if (distance <= 256)
+				distanceSymbol[distance - 1] = (unsigned char) symbol;
+			else
+				distanceSymbol[256 + ((distance - 1) >> 7)] = (unsigned char) symbol;
+		}
+	}
+}
+
+void writeChunk(FILE* fp, const char* type, const unsigned char* data, size_t length) {
+	unsigned char word[4];
+	putBigEndian32(word, (uint32_t) length);
+	fwrite(word, 1, 4, fp);
+	fwrite(type, 1, 4, fp);
+	if (length > 0)
+		fwrite(data, 1, length, fp);
+
+	uint32_t crc = crc32Update(0xFFFFFFFFu, (const unsigned char*) type, 4);
+	crc = crc32Update(crc, data, length) ^ 0xFFFFFFFFu;
+	putBigEndian32(word, crc);
+	fwrite(word, 1, 4, fp);
+}
+
+uint32_t crc32Update(uint32_t crc, const unsigned char* data, size_t length) {
+	for (size_t k=0; k<length; k++)
+		crc = crcTable[(crc ^ data[k]) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+uint32_t adler32(const unsigned char* data, size_t length) {
+	uint32_t a = 1, b = 0;
+	while (length > 0) {
+		//	the largest number of bytes before b can overflow
+		size_t block = (length < 5552) ? length : 5552;
+		length -= block;
+		while (block-- > 0) {
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+void putBigEndian32(unsigned char* dest, uint32_t value) {
+	dest[0] = (unsigned char) (value >> 24);
+	dest[1] = (unsigned char) (value >> 16);
+	dest[2] = (unsigned char) (value >> 8);
+	dest[3] = (unsigned char) value;
+}
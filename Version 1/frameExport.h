@@ -0,0 +1,58 @@
+//
+//  frameExport.h
+//  Cellular Automaton
+//
+//  Writes generations of the grid to disk as PNG/PPM images (and optionally
+//  as a raw RGB stream on stdout) without going through the GLUT window.
+//
+
+#ifndef FRAME_EXPORT_H
+#define FRAME_EXPORT_H
+
+#include "gridLayout.h"
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef enum ExportFormat {
+	EXPORT_PPM = 0,
+	EXPORT_PNG
+} ExportFormat;
+
+typedef struct ExportSettings {
+	//	write one frame every `interval` generations (0 disables the export)
+	unsigned int interval;
+	//	directory the numbered frame files are written into
+	const char* directory;
+	ExportFormat format;
+	//	size in pixels of a cell in the output images
+	unsigned int scale;
+	//	number of encoder threads
+	unsigned int numEncoders;
+	//	also send every frame as raw 8-bit RGB on stdout
+	int rawStdout;
+	//	do not write any image files (useful with rawStdout)
+	int noFiles;
+} ExportSettings;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void initializeExport(const ExportSettings* settings, unsigned int numRows, unsigned int numCols);
+//	Copies the whole frame right away (when a thread completes a generation
+//	while the others go on with theirs, as in wavefront mode)
+void exportGeneration(const Grid* grid, unsigned long generation);
+//	At the barrier: only reserves a slot for the generation's frame.  Each
+//	worker then copies its own rows with exportRows() at the start of the
+//	next generation, which only reads the grid, and the last one to be done
+//	hands the frame to the encoders.
+void scheduleExport(unsigned long generation);
+void exportRows(const Grid* grid, int firstRow, int endRow);
+//	At the barrier, before exiting: copies the frame no worker will copy
+void flushScheduledExport(const Grid* grid);
+void shutdownExport(void);
+unsigned long exportDroppedFrames(void);
+
+#endif // FRAME_EXPORT_H
@@ -0,0 +1,96 @@
+//
+//  genStats.c
+//  Cellular Automaton
+//
+
+#include <string.h>
+#include <stdatomic.h>
+#include "genStats.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+//	Sequence lock: odd while the totals are being written
+atomic_uint publishedSequence = 0;
+GenerationStats publishedStats;
+
+FILE* statsCSV = NULL;
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void clearStats(GenerationStats* stats) {
+	memset(stats, 0, sizeof(GenerationStats));
+}
+
+uint64_t mixHash(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
+}
+
+void addStats(GenerationStats* total, const GenerationStats* part) {
+	total->hash += part->hash;
+	total->population += part->population;
+	total->births += part->births;
+	total->deaths += part->deaths;
+	for (int k=0; k<MAX_CELL_STATES; k++)
+		total->stateCount[k] += part->stateCount[k];
+}
+
+void publishStats(const GenerationStats* stats) {
+	unsigned int seq = atomic_load_explicit(&publishedSequence, memory_order_relaxed);
+	atomic_store_explicit(&publishedSequence, seq+1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	memcpy(&publishedStats, stats, sizeof(GenerationStats));
+	atomic_store_explicit(&publishedSequence, seq+2, memory_order_release);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	A reader that overlaps with a publication simply tries again; there is
+ *	only one publication per generation, so this hardly ever loops.
+ *---------------------------------------------------------------------------
+ */
+void readStats(GenerationStats* stats) {
+	unsigned int before, after;
+	do {
+		before = atomic_load_explicit(&publishedSequence, memory_order_acquire);
+		memcpy(stats, &publishedStats, sizeof(GenerationStats));
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&publishedSequence, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+}
+
+int openStatsCSV(const char* path) {
+	statsCSV = fopen(path, "w");
+	if (statsCSV == NULL)
+		return 0;
+	fprintf(statsCSV, "generation,population,births,deaths");
+	for (int k=1; k<MAX_CELL_STATES; k++)
+		fprintf(statsCSV, ",state%d", k);
+	fprintf(statsCSV, "\n");
+	return 1;
+}
+
+void writeStatsCSV(const GenerationStats* stats) {
+	if (statsCSV == NULL)
+		return;
+	fprintf(statsCSV, "%lu,%lu,%lu,%lu", stats->generation, stats->population,
+			stats->births, stats->deaths);
+	for (int k=1; k<MAX_CELL_STATES; k++)
+		fprintf(statsCSV, ",%lu", stats->stateCount[k]);
+	fprintf(statsCSV, "\n");
+}
+
+void closeStatsCSV(void) {
+	if (statsCSV != NULL) {
+		fclose(statsCSV);
+		statsCSV = NULL;
+	}
+}
@@ -0,0 +1,52 @@
+//
+//  genStats.h
+//  Cellular Automaton
+//
+//  Population statistics gathered while the next generation is written:
+//  each worker counts its own rows, and the counts are added up by the
+//  thread that completes the generation.  No extra pass over the grid.
+//
+
+#ifndef GEN_STATS_H
+#define GEN_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "gl_frontEnd.h"
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef struct GenerationStats {
+	unsigned long generation;
+	unsigned long population;
+	unsigned long births;
+	unsigned long deaths;
+	//	number of cells in each state (in color mode the state is the age,
+	//	with a multi-state rule the states past 1 are the dying ones)
+	unsigned long stateCount[MAX_CELL_STATES];
+	//	hash of which cells are not dead (ages are ignored).  The sum of one
+	//	hash per row, so it doesn't depend on how rows are split in slabs.
+	uint64_t hash;
+} GenerationStats;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void clearStats(GenerationStats* stats);
+//	Mixes a 64-bit word into a hash (splitmix64 finalizer)
+uint64_t mixHash(uint64_t x);
+void addStats(GenerationStats* total, const GenerationStats* part);
+
+//	Makes the totals of a completed generation visible to other threads
+void publishStats(const GenerationStats* stats);
+//	Consistent copy of the last published totals (never blocks the publisher)
+void readStats(GenerationStats* stats);
+
+int openStatsCSV(const char* path);
+void writeStatsCSV(const GenerationStats* stats);
+void closeStatsCSV(void);
+
+#endif // GEN_STATS_H
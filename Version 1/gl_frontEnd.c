@@ -9,7 +9,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include "gl_frontEnd.h"
+#include "traceEvents.h"
+#include "genStats.h"
+#include "commandQueue.h"
+#include "cycleDetect.h"
+#include "cellEdits.h"
 
 //---------------------------------------------------------------------------
 //  Private functions' prototypes
@@ -19,11 +25,16 @@ void myResize(int w, int h);
 void displayTextualInfo(const char* infoStr, int x, int y, int isLarge);
 void myMouse(int b, int s, int x, int y);
 void myGridPaneMouse(int b, int s, int x, int y);
+void myGridPaneMotion(int x, int y);
+void mySpecialKeys(int key, int x, int y);
 void myStatePaneMouse(int b, int s, int x, int y);
 void myKeyboard(unsigned char c, int x, int y);
 void myMenuHandler(int value);
 void mySubmenuHandler(int colorIndex);
 void myTimer(int val);
+void changeSpeed(double factor);
+void setColorMode(int on);
+void queueCellEdit(const CellEdit* edit);
 void* threadFunc(void );
 
 //---------------------------------------------------------------------------
@@ -36,7 +47,21 @@ extern unsigned int rule;
 
 extern unsigned int colorMode;
 
-extern int applicationSpeed;
+extern int wrapFrame;
+
+extern double targetRate;
+
+extern int workersParked;
+
+extern unsigned long fastForwardRemaining, fastForwardTotal;
+
+extern int numRows, numCols;
+
+extern int numProcesses;
+
+extern int planeMode, followLiveCells;
+
+extern long viewRow, viewCol;
 
 //---------------------------------------------------------------------------
 //  Interface constants
@@ -66,12 +91,23 @@ const int TEXT_PADDING = 0;
 const float kTextColor[4] = {1.f, 1.f, 1.f, 1.f};
 
 //	Predefine some colors for "age"-based rendering of the cells
-GLfloat cellColor[NB_COLORS][4] = {	{0.f, 0.f, 0.f, 1.f},	//	BLACK_COL
-									{1.f, 1.f, 1.f, 1.f},	//	WHITE_COL,
-									{0.f, 0.f, 1.f, 1.f},	//	BLUE_COL,
-									{0.f, 1.f, 0.f, 1.f},	//	GREEN_COL,
-									{1.f, 1.f, 0.f, 1.f},	//	YELLOW_COL,
-									{1.f, 0.f, 0.f, 1.f}};	//	RED_COL
+//	(and of the dying states of multi-state rules, which fade out past red)
+GLfloat cellColor[MAX_CELL_STATES][4] = {	{0.f, 0.f, 0.f, 1.f},	//	BLACK_COL
+											{1.f, 1.f, 1.f, 1.f},	//	WHITE_COL,
+											{0.f, 0.f, 1.f, 1.f},	//	BLUE_COL,
+											{0.f, 1.f, 0.f, 1.f},	//	GREEN_COL,
+											{1.f, 1.f, 0.f, 1.f},	//	YELLOW_COL,
+											{1.f, 0.f, 0.f, 1.f},	//	RED_COL
+											{.9f, 0.f, .1f, 1.f},
+											{.8f, 0.f, .2f, 1.f},
+											{.7f, 0.f, .3f, 1.f},
+											{.6f, 0.f, .3f, 1.f},
+											{.5f, 0.f, .3f, 1.f},
+											{.4f, 0.f, .3f, 1.f},
+											{.3f, 0.f, .25f, 1.f},
+											{.25f, 0.f, .2f, 1.f},
+											{.2f, 0.f, .15f, 1.f},
+											{.15f, 0.f, .1f, 1.f}};
 	
 
 //	Initial position of the window
@@ -113,46 +149,240 @@ int	gMainWindow,
 
 int drawGridLines = 0;
 
+//	speedup/slowdown multiply the target generations/sec by this
+#define SPEED_STEP	1.25
+#define MIN_RATE	0.5
+#define MAX_RATE	100000.0
+//	pace restored when leaving unlimited speed
+double limitedRate = 60.0;
+
+//	mouse edits: radius of the brush, pattern stamped by a left click (-1:
+//	the left button paints), and the button & cell of the stroke being drawn
+int brushRadius = 0;
+int stampIndex = -1;
+int strokeButton = -1;
+int strokeRow, strokeCol;
+
+//	viewport: zoom (1: the whole grid fills the pane; the pane shows
+//	1/zoomLevel of the rows & columns) and grid coordinates of the pane's
+//	bottom-left corner
+#define ZOOM_STEP			2.0
+//	largest zoom: cells of at most that many pixels
+#define MAX_CELL_PIXELS		64.0
+double zoomLevel = 1.0;
+double viewportRow = 0.0, viewportCol = 0.0;
+//	last position of a middle-button drag (which pans)
+int panX, panY;
+//	mouse wheel, as freeglut reports it
+#define WHEEL_UP_BUTTON		3
+#define WHEEL_DOWN_BUTTON	4
+
+//	The visible cells go through a texture, at most one texel per pixel (2
+//	per cell across on a hexagonal lattice, for the half-cell shift)
+#define VIEW_TEXTURE_SIZE	2048
+#define REDRAW_INTERVAL_MS	16
+GLuint viewTexture = 0;
+GLubyte* viewTexels = NULL;
+int* sampleCol = NULL;
+int* sampleBand = NULL;
+
 //---------------------------------------------------------------------------
 //	Drawing functions
 //---------------------------------------------------------------------------
 
 /*
  *---------------------------------------------------------------------------
- *	This is the function that does the actual grid drawing
+ *	Size of a cell on screen, in pixels, at the current zoom
  *---------------------------------------------------------------------------
  */
-void drawGrid(int**grid, unsigned int numRows, unsigned int numCols) {
-	const float	DH = (1.f * GRID_PANE_WIDTH) / numCols,
-				DV = (1.f * GRID_PANE_HEIGHT) / numRows;
-	
-	//	Display the grid as a series of quad strips
-	for (unsigned int i=0; i<numRows; i++) {
-		glBegin(GL_QUAD_STRIP);
-			for (unsigned int j=0; j<numCols; j++) {
-				glColor4fv(cellColor[grid[i][j]]);
-
-				glVertex2f(j*DH, i*DV);
-				glVertex2f(j*DH, (i+1)*DV);
-				glVertex2f((j+1)*DH, i*DV);
-				glVertex2f((j+1)*DH, (i+1)*DV);
+void cellExtent(float* dh, float* dv) {
+	*dh = (float) (zoomLevel * GRID_PANE_WIDTH / (hexLattice() ? numCols + 0.5 : numCols));
+	*dv = (float) (zoomLevel * GRID_PANE_HEIGHT / numRows);
+}
+
+//	Keeps the zoom in its range and the viewport inside the grid
+void clampViewport(void) {
+	double maxZoom = MAX_CELL_PIXELS * numCols / GRID_PANE_WIDTH;
+	if (maxZoom < MAX_CELL_PIXELS * numRows / GRID_PANE_HEIGHT)
+		maxZoom = MAX_CELL_PIXELS * numRows / GRID_PANE_HEIGHT;
+	if (zoomLevel > maxZoom)
+		zoomLevel = maxZoom;
+	if (zoomLevel < 1.0)
+		zoomLevel = 1.0;
+	double maxRow = numRows * (1.0 - 1.0 / zoomLevel);
+	double maxCol = (hexLattice() ? numCols + 0.5 : numCols) * (1.0 - 1.0 / zoomLevel);
+	viewportRow = (viewportRow < 0.0) ? 0.0 : (viewportRow > maxRow ? maxRow : viewportRow);
+	viewportCol = (viewportCol < 0.0) ? 0.0 : (viewportCol > maxCol ? maxCol : viewportCol);
+}
+
+//	Multiplies the zoom, keeping the grid point under pixel (x, y) in place
+void zoomAt(double factor, int x, int y) {
+	float DH, DV;
+	cellExtent(&DH, &DV);
+	double col = viewportCol + x / DH;
+	double row = viewportRow + (GRID_PANE_HEIGHT - y) / DV;
+	zoomLevel *= factor;
+	clampViewport();
+	cellExtent(&DH, &DV);
+	viewportCol = col - x / DH;
+	viewportRow = row - (GRID_PANE_HEIGHT - y) / DV;
+	clampViewport();
+}
+
+//	Moves the viewport by a number of pixels (the grid follows the mouse).
+//	On the plane, panning past the window's edge moves the window itself
+//	(unless it follows the live cells), by whole cells: the viewport keeps
+//	its place in the window, which brings the new cells in between two
+//	generations.
+void panBy(int dx, int dy) {
+	float DH, DV;
+	cellExtent(&DH, &DV);
+	viewportCol -= dx / DH;
+	viewportRow += dy / DV;
+	if (planeMode && !followLiveCells) {
+		double maxRow = numRows * (1.0 - 1.0 / zoomLevel);
+		double maxCol = numCols * (1.0 - 1.0 / zoomLevel);
+		long rows = (long) (viewportRow < 0.0 ? floor(viewportRow) :
+							(viewportRow > maxRow ? ceil(viewportRow - maxRow) : 0.0));
+		long cols = (long) (viewportCol < 0.0 ? floor(viewportCol) :
+							(viewportCol > maxCol ? ceil(viewportCol - maxCol) : 0.0));
+		if (rows != 0 || cols != 0) {
+			char command[COMMAND_LENGTH];
+			snprintf(command, sizeof(command), "view %ld %ld", rows, cols);
+			pushCommand(command);
+			viewportRow -= rows;
+			viewportCol -= cols;
+		}
+	}
+	clampViewport();
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	This is the function that does the actual grid drawing.  Only the cells
+ *	inside the viewport are read: they go into a texture, one texel per
+ *	cell, or one per pixel (the cell in its middle) once cells are smaller
+ *	than pixels, and the texture is drawn as a single quad.  So a frame
+ *	costs the visible cells, and never more than the pane's pixels,
+ *	whatever the size of the grid.
+ *	On a hexagonal lattice, odd rows are shifted half a cell to the right,
+ *	so that each cell touches the 2 cells above and the 2 below that are its
+ *	neighbors (as long as every visible cell gets its own texel).
+ *---------------------------------------------------------------------------
+ */
+void drawGrid(const Grid* grid, unsigned int numRows, unsigned int numCols) {
+	const int hex = hexLattice();
+	clampViewport();
+	float DH, DV;
+	cellExtent(&DH, &DV);
+
+	//	the visible cells (on a hexagonal lattice, the shifted half of the
+	//	cell left of the viewport may be visible too)
+	int firstRow = (int) viewportRow;
+	int firstCol = hex ? (int) floor(viewportCol - 0.5) : (int) viewportCol;
+	if (firstCol < 0)
+		firstCol = 0;
+	int endRow = (int) ceil(viewportRow + GRID_PANE_HEIGHT / DV);
+	int endCol = (int) ceil(viewportCol + GRID_PANE_WIDTH / DH);
+	if (endRow > (int) numRows)
+		endRow = numRows;
+	if (endCol > (int) numCols)
+		endCol = numCols;
+	const int texRows = (endRow - firstRow < GRID_PANE_HEIGHT) ? endRow - firstRow : GRID_PANE_HEIGHT;
+	const int texCols = (endCol - firstCol < GRID_PANE_WIDTH) ? endCol - firstCol : GRID_PANE_WIDTH;
+	const int halfCells = hex && texCols == endCol - firstCol;
+	const int texWidth = halfCells ? 2*texCols + 1 : texCols;
+
+	if (viewTexture == 0) {
+		glGenTextures(1, &viewTexture);
+		glBindTexture(GL_TEXTURE_2D, viewTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, VIEW_TEXTURE_SIZE, VIEW_TEXTURE_SIZE, 0,
+					 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		viewTexels = (GLubyte*) malloc((size_t) 4*(2*GRID_PANE_WIDTH + 1)*GRID_PANE_HEIGHT);
+		sampleCol = (int*) malloc(GRID_PANE_WIDTH*sizeof(int));
+		sampleBand = (int*) malloc(GRID_PANE_WIDTH*sizeof(int));
+	}
+	GLuint colors[MAX_CELL_STATES];
+	for (int k=0; k<MAX_CELL_STATES; k++) {
+		GLubyte* rgba = (GLubyte*) (colors + k);
+		for (int c=0; c<4; c++)
+			rgba[c] = (GLubyte) (255.f*cellColor[k][c]);
+	}
+
+	//	column (and band, on a tiled grid) of each texel column
+	for (int x=0, b=0; x<texCols; x++) {
+		int j = firstCol + (int) ((x + 0.5) * (endCol - firstCol) / texCols);
+		while (grid->firstCol[b+1] <= j)
+			b++;
+		sampleCol[x] = j;
+		sampleBand[x] = b;
+	}
+	for (int y=0; y<texRows; y++) {
+		int i = firstRow + (int) ((y + 0.5) * (endRow - firstRow) / texRows);
+		GLuint* texels = (GLuint*) viewTexels + (size_t) y*texWidth;
+		if (halfCells) {
+			const int shift = i & 1;
+			texels[shift ? 0 : 2*texCols] = colors[0];
+			for (int x=0; x<texCols; x++) {
+				GLuint color = colors[grid->band[sampleBand[x]][i][sampleCol[x]]];
+				texels[2*x + shift] = color;
+				texels[2*x + shift + 1] = color;
 			}
-		glEnd();
+		} else {
+			for (int x=0; x<texCols; x++)
+				texels[x] = colors[grid->band[sampleBand[x]][i][sampleCol[x]]];
+		}
 	}
 
-	if (drawGridLines) {
-		//	Then draw a grid of lines on top of the squares
+	glBindTexture(GL_TEXTURE_2D, viewTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texWidth, texRows, GL_RGBA, GL_UNSIGNED_BYTE, viewTexels);
+	const float x0 = (float) ((firstCol - viewportCol) * DH);
+	const float x1 = (float) ((endCol + (halfCells ? 0.5 : 0.0) - viewportCol) * DH);
+	const float y0 = (float) ((firstRow - viewportRow) * DV);
+	const float y1 = (float) ((endRow - viewportRow) * DV);
+	const float s1 = (float) texWidth / VIEW_TEXTURE_SIZE,
+				t1 = (float) texRows / VIEW_TEXTURE_SIZE;
+	glEnable(GL_TEXTURE_2D);
+	glColor4f(1.f, 1.f, 1.f, 1.f);
+	glBegin(GL_QUADS);
+		glTexCoord2f(0.f, 0.f);
+		glVertex2f(x0, y0);
+		glTexCoord2f(s1, 0.f);
+		glVertex2f(x1, y0);
+		glTexCoord2f(s1, t1);
+		glVertex2f(x1, y1);
+		glTexCoord2f(0.f, t1);
+		glVertex2f(x0, y1);
+	glEnd();
+	glDisable(GL_TEXTURE_2D);
+
+	//	(only once the cells are large enough for the lines not to hide them)
+	if (drawGridLines && DH >= 4.f && DV >= 4.f) {
+		//	Then draw a grid of lines on top of the visible cells
 		glColor4f(0.5f, 0.5f, 0.5f, 1.f);
 		glBegin(GL_LINES);
 			//	Horizontal
-			for (int i=0; i<= numRows; i++) {
-				glVertex2i(0, i*DV);
-				glVertex2i(GRID_PANE_WIDTH, i*DV);
+			for (int i=firstRow; i<=endRow; i++) {
+				glVertex2f(x0, (i - viewportRow)*DV);
+				glVertex2f(x1, (i - viewportRow)*DV);
 			}
-			//	Vertical
-			for (int j=0; j<= numCols; j++) {
-				glVertex2i(j*DH, 0);
-				glVertex2i(j*DH, GRID_PANE_HEIGHT);
+			//	Vertical (one row at a time when the rows are shifted)
+			if (hex) {
+				for (int i=firstRow; i<endRow; i++) {
+					const double shift = (i & 1) ? 0.5 : 0.0;
+					for (int j=firstCol; j<=endCol; j++) {
+						glVertex2f((j + shift - viewportCol)*DH, (i - viewportRow)*DV);
+						glVertex2f((j + shift - viewportCol)*DH, (i + 1 - viewportRow)*DV);
+					}
+				}
+			} else {
+				for (int j=firstCol; j<=endCol; j++) {
+					glVertex2f((j - viewportCol)*DH, y0);
+					glVertex2f((j - viewportCol)*DH, y1);
+				}
 			}
 		glEnd();
 	}
@@ -222,15 +452,122 @@ void displayTextualInfo(const char* infoStr, int xPos, int yPos, int isLarge) {
 }
 
 
-void drawState(unsigned int numLiveThreads) {
+void drawState(unsigned int numLiveThreads, const PerfSummary* perf, const GenerationStats* stats) {
 	const int H_PAD = STATE_PANE_WIDTH / 16;
 	const int TOP_LEVEL_TXT_Y = 4*STATE_PANE_HEIGHT / 5;
+	const int LINE_HEIGHT = SMALL_FONT_HEIGHT + 6;
 
 	//	Build, then display text info for the red, green, and blue tanks
 	char infoStr[256];
 	//	display info about number of live threads
 	sprintf(infoStr, "Live Threads: %d", numLiveThreads);
 	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y, 1);
+
+	//	global performance figures
+	int y = TOP_LEVEL_TXT_Y - 2*LINE_HEIGHT;
+	sprintf(infoStr, "Generation: %lu", perf->generation);
+	displayTextualInfo(infoStr, H_PAD, y, 0);
+	y -= LINE_HEIGHT;
+	if (perf->targetGensPerSec > 0.0)
+		sprintf(infoStr, "Gens/sec: %.1f / %.1f target", perf->gensPerSec, perf->targetGensPerSec);
+	else
+		sprintf(infoStr, "Gens/sec: %.1f / unlimited", perf->gensPerSec);
+	displayTextualInfo(infoStr, H_PAD, y, 0);
+	y -= LINE_HEIGHT;
+	sprintf(infoStr, "Mcells/sec: %.2f", 1e-6*perf->cellsPerSec);
+	displayTextualInfo(infoStr, H_PAD, y, 0);
+	y -= LINE_HEIGHT;
+	sprintf(infoStr, "Sync overhead: %.1f%%   Sleep: %.1f%%",
+			100.0*perf->syncOverhead, 100.0*perf->sleepFraction);
+	displayTextualInfo(infoStr, H_PAD, y, 0);
+	y -= LINE_HEIGHT;
+	sprintf(infoStr, "Population: %lu  (+%lu / -%lu)", stats->population, stats->births, stats->deaths);
+	displayTextualInfo(infoStr, H_PAD, y, 0);
+	y -= LINE_HEIGHT;
+	if (planeMode) {
+		sprintf(infoStr, "Window: row %ld, col %ld%s", viewRow, viewCol,
+				followLiveCells ? " (following, o)" : " (o: follow)");
+		displayTextualInfo(infoStr, H_PAD, y, 0);
+		y -= LINE_HEIGHT;
+	}
+	sprintf(infoStr, "Brush: %d [ ]   Stamp: %s (p)", brushRadius,
+			stampIndex < 0 ? "none" : stampPatternName(stampIndex));
+	displayTextualInfo(infoStr, H_PAD, y, 0);
+	y -= LINE_HEIGHT;
+	if (fastForwardRemaining > 0) {
+		unsigned long done = fastForwardTotal - fastForwardRemaining;
+		sprintf(infoStr, "Fast-forward: %lu / %lu  (%.0f%%)", done, fastForwardTotal,
+				100.0 * done / fastForwardTotal);
+		displayTextualInfo(infoStr, H_PAD, y, 0);
+		y -= LINE_HEIGHT;
+	}
+	CycleInfo cycle = currentCycle();
+	if (cycle.period > 0) {
+		sprintf(infoStr, "Cycle: period %u since gen %lu%s", cycle.period, cycle.detectedAt,
+				workersParked ? " (parked)" : "");
+		displayTextualInfo(infoStr, H_PAD, y, 0);
+		y -= LINE_HEIGHT;
+	}
+	if (colorMode || cellStateCount() > NB_COLORS) {
+		//	age (or dying state) distribution, in the colors of the states
+		int x = H_PAD;
+		for (int k=1; k<(int) cellStateCount(); k++) {
+			if (x > STATE_PANE_WIDTH - 60) {
+				x = H_PAD;
+				y -= LINE_HEIGHT;
+			}
+			sprintf(infoStr, "%lu ", stats->stateCount[k]);
+			glColor4fv(cellColor[k]);
+			glBegin(GL_QUADS);
+				glVertex2i(x, y);
+				glVertex2i(x + 8, y);
+				glVertex2i(x + 8, y + 8);
+				glVertex2i(x, y + 8);
+			glEnd();
+			displayTextualInfo(infoStr, x + 11, y, 0);
+			x += 11 + 7*(int) strlen(infoStr);
+		}
+		y -= LINE_HEIGHT;
+	}
+	y -= LINE_HEIGHT;
+
+	//	one utilization bar per thread: share of wall time spent computing
+	const int LABEL_WIDTH = 40;
+	const int BAR_WIDTH = STATE_PANE_WIDTH - 2*H_PAD - LABEL_WIDTH - 45;
+	const int BAR_HEIGHT = SMALL_FONT_HEIGHT;
+	unsigned int numShown = perf->numThreads < MAX_DISPLAYED_THREADS ? perf->numThreads : MAX_DISPLAYED_THREADS;
+	for (unsigned int k=0; k<numShown && y > LINE_HEIGHT; k++) {
+		double u = perf->utilization[k];
+		if (u > 1.0)
+			u = 1.0;
+		int x0 = H_PAD + LABEL_WIDTH;
+
+		sprintf(infoStr, "T%u", k+1);
+		displayTextualInfo(infoStr, H_PAD, y, 0);
+
+		glColor4f(0.3f, 0.3f, 0.3f, 1.f);
+		glBegin(GL_QUADS);
+			glVertex2i(x0, y - 2);
+			glVertex2i(x0 + BAR_WIDTH, y - 2);
+			glVertex2i(x0 + BAR_WIDTH, y - 2 + BAR_HEIGHT);
+			glVertex2i(x0, y - 2 + BAR_HEIGHT);
+		glEnd();
+		glColor4fv(cellColor[GREEN_COL]);
+		glBegin(GL_QUADS);
+			glVertex2i(x0, y - 2);
+			glVertex2i(x0 + (int) (u*BAR_WIDTH), y - 2);
+			glVertex2i(x0 + (int) (u*BAR_WIDTH), y - 2 + BAR_HEIGHT);
+			glVertex2i(x0, y - 2 + BAR_HEIGHT);
+		glEnd();
+
+		sprintf(infoStr, "%3.0f%%", 100.0*u);
+		displayTextualInfo(infoStr, x0 + BAR_WIDTH + 5, y, 0);
+		y -= LINE_HEIGHT;
+	}
+	if (perf->numThreads > numShown) {
+		sprintf(infoStr, "(+%u more threads)", perf->numThreads - numShown);
+		displayTextualInfo(infoStr, H_PAD, y, 0);
+	}
 }
 
 /*
@@ -276,17 +613,80 @@ void myMouse(int button, int state, int x, int y) {
 }
 /*
  *---------------------------------------------------------------------------
- *	This function is called when a mouse event occurs in the grid pane
+ *	Queues a mouse edit, or a paint, erase or stamp command.  The processes
+ *	sharing a grid (-processes) each only have their own rows, so edits are
+ *	refused there rather than applied to some of the processes.
+ *---------------------------------------------------------------------------
+ */
+void queueCellEdit(const CellEdit* edit) {
+	if (numProcesses > 1)
+		fprintf(stderr, "cells can't be edited with -processes\n");
+	else if (!pushCellEdit(edit))
+		fprintf(stderr, "too many edits waiting: one was dropped\n");
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Cell under a point of the grid pane (window coordinates: y grows
+ *	downward, while row 0 is drawn at the bottom)
+ *---------------------------------------------------------------------------
+ */
+void paneToCell(int x, int y, int* row, int* col) {
+	float DH, DV;
+	cellExtent(&DH, &DV);
+	*row = (int) floor(viewportRow + (GRID_PANE_HEIGHT - y - 0.5) / DV);
+	const double shift = (hexLattice() && (*row & 1)) ? 0.5 : 0.0;
+	*col = (int) floor(viewportCol + (x + 0.5) / DH - shift);
+}
+
+//	The brush from the last cell of the stroke to the one under (x, y)
+void extendStroke(int x, int y) {
+	int row, col;
+	paneToCell(x, y, &row, &col);
+	CellEdit edit = {strokeButton == GLUT_LEFT_BUTTON ? EDIT_PAINT : EDIT_ERASE,
+					 strokeRow, strokeCol, row, col, brushRadius};
+	queueCellEdit(&edit);
+	strokeRow = row;
+	strokeCol = col;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	This function is called when a mouse event occurs in the grid pane.
+ *	The left button paints live cells (or stamps the selected pattern), the
+ *	right one erases; the edits are applied between two generations.  The
+ *	wheel zooms around the mouse, and the middle button pans.
  *---------------------------------------------------------------------------
  */
 void myGridPaneMouse(int button, int state, int x, int y) {
 	switch (button) {
+		case WHEEL_UP_BUTTON:
+		case WHEEL_DOWN_BUTTON:
+			if (state == GLUT_DOWN)
+				zoomAt(button == WHEEL_UP_BUTTON ? sqrt(ZOOM_STEP) : 1.0 / sqrt(ZOOM_STEP), x, y);
+			break;
+
+		case GLUT_MIDDLE_BUTTON:
+			strokeButton = (state == GLUT_DOWN) ? button : -1;
+			panX = x;
+			panY = y;
+			break;
+
 		case GLUT_LEFT_BUTTON:
+		case GLUT_RIGHT_BUTTON:
 			if (state == GLUT_DOWN) {
-				//	do something
+				paneToCell(x, y, &strokeRow, &strokeCol);
+				if (button == GLUT_LEFT_BUTTON && stampIndex >= 0) {
+					CellEdit edit = {EDIT_STAMP, strokeRow, strokeCol, strokeRow, strokeCol, stampIndex};
+					queueCellEdit(&edit);
+				}
+				else {
+					strokeButton = button;
+					extendStroke(x, y);
+				}
 			}
 			else if (state == GLUT_UP) {
-				//	exit(0);
+				strokeButton = -1;
 			}
 			break;
 			
@@ -297,6 +697,19 @@ void myGridPaneMouse(int button, int state, int x, int y) {
 	glutSetWindow(gMainWindow);
 	glutPostRedisplay();
 }
+
+//	Mouse moved with a button down in the grid pane
+void myGridPaneMotion(int x, int y) {
+	if (strokeButton == GLUT_MIDDLE_BUTTON) {
+		panBy(x - panX, y - panY);
+		panX = x;
+		panY = y;
+		glutPostRedisplay();
+	}
+	else if (strokeButton >= 0)
+		extendStroke(x, y);
+}
+
 /*
  *---------------------------------------------------------------------------
  *	This function is called when a mouse event occurs in the state pane
@@ -322,30 +735,104 @@ void myStatePaneMouse(int button, int state, int x, int y)
 	glutPostRedisplay();
 }
 
+/*
+ *---------------------------------------------------------------------------
+ *	Multiplies the target number of generations per second.  Slowing down
+ *	from unlimited speed starts from the last limited pace.
+ *---------------------------------------------------------------------------
+ */
+void changeSpeed(double factor) {
+	if (targetRate <= 0.0) {
+		if (factor < 1.0)
+			targetRate = limitedRate;
+		return;
+	}
+	targetRate *= factor;
+	if (targetRate < MIN_RATE)
+		targetRate = MIN_RATE;
+	if (targetRate > MAX_RATE)
+		targetRate = MAX_RATE;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Color mode draws the cells by age, which the plane's chunks don't keep
+ *	(only which cells are alive): it is refused there
+ *---------------------------------------------------------------------------
+ */
+void setColorMode(int on) {
+	if (on && planeMode)
+		fprintf(stderr, "color mode is not available with -plane (the plane doesn't keep the cells' ages)\n");
+	else
+		colorMode = on;
+}
+
 /*
  *---------------------------------------------------------------------------
  *	Takes the message from the pipe and simulates a keypress with it
  *---------------------------------------------------------------------------
  */
 void pipeToCommand(char *pipeString) {
-	if(strncmp("rule 1", pipeString, 6) == 0) {
-		rule = GAME_OF_LIFE_RULE;
-	} else if(strncmp("rule 2", pipeString, 6) == 0) {
-		rule = CORAL_GROWTH_RULE;
-	} else if(strncmp("rule 3", pipeString, 6) == 0) {
-		rule = AMOEBA_RULE;
-	} else if(strncmp("rule 4", pipeString, 6) == 0) {
-		rule = MAZE_RULE;
-	} else if(strncmp("color on", pipeString, 6) == 0) {
-		colorMode = 1;
-	} else if(strncmp("color off", pipeString, 6) == 0) {
-		colorMode = 0;
-	} else if(strncmp("speedup", pipeString, 6) == 0) {
-		if(applicationSpeed > 1)
-            applicationSpeed -= 10;
-	} else if(strncmp("rule 4", pipeString, 6) == 0) {
-		if(applicationSpeed < 5000)
-           	applicationSpeed += 10;
+	if(strncmp("rule ", pipeString, 5) == 0) {
+		//	"rule 1" - "rule 4", "rule B36/S23", "rule B2/S/C3", "rule R5,C2,M1,S34..58,B34..45,NM"...
+		//	(through setCustomRule(), which also refills the block table)
+		char ruleText[64] = "";
+		sscanf(pipeString + 5, "%63s", ruleText);
+		if (!setCustomRule(ruleText))
+			fprintf(stderr, "not a rule: %s\n", ruleText);
+	} else if(strncmp("color on", pipeString, 8) == 0) {
+		setColorMode(1);
+	} else if(strncmp("color off", pipeString, 9) == 0) {
+		setColorMode(0);
+	} else if(strncmp("wrap on", pipeString, 7) == 0) {
+		setWrapFrame(1);
+	} else if(strncmp("wrap off", pipeString, 8) == 0) {
+		setWrapFrame(0);
+	} else if(strncmp("speedup", pipeString, 7) == 0) {
+		changeSpeed(SPEED_STEP);
+	} else if(strncmp("slowdown", pipeString, 8) == 0) {
+		changeSpeed(1.0 / SPEED_STEP);
+	} else if(strncmp("speed ", pipeString, 6) == 0) {
+		//	"speed N" (generations/sec), "speed unlimited" or "speed 0"
+		double rate = 0.0;
+		sscanf(pipeString + 6, "%lf", &rate);
+		targetRate = rate > 0.0 ? rate : 0.0;
+	} else if(strncmp("ff ", pipeString, 3) == 0 || strncmp("step ", pipeString, 5) == 0) {
+		//	"ff N" / "step N": run N generations at full speed, "ff cancel" stops
+		unsigned long numGenerations = 0;
+		sscanf(strchr(pipeString, ' ') + 1, "%lu", &numGenerations);
+		fastForwardTotal = numGenerations;
+		fastForwardRemaining = numGenerations;
+	} else if(strncmp("paint ", pipeString, 6) == 0 || strncmp("erase ", pipeString, 6) == 0) {
+		//	"paint ROW COL [RADIUS]", "erase ROW COL [RADIUS]"
+		CellEdit edit = {pipeString[0] == 'p' ? EDIT_PAINT : EDIT_ERASE, 0, 0, 0, 0, 0};
+		if (sscanf(pipeString + 6, "%d %d %d", &edit.row, &edit.col, &edit.size) >= 2) {
+			edit.toRow = edit.row;
+			edit.toCol = edit.col;
+			queueCellEdit(&edit);
+		}
+	} else if(strncmp("stamp ", pipeString, 6) == 0) {
+		//	"stamp NAME ROW COL"
+		char name[32] = "";
+		CellEdit edit = {EDIT_STAMP, 0, 0, 0, 0, 0};
+		if (sscanf(pipeString + 6, "%31s %d %d", name, &edit.row, &edit.col) == 3 &&
+			(edit.size = findStampPattern(name)) >= 0)
+			queueCellEdit(&edit);
+		else
+			fprintf(stderr, "not a stamp: %s\n", pipeString + 6);
+	} else if(strncmp("view ", pipeString, 5) == 0) {
+		//	"view ROWS COLS": moves the plane's window (down & east for positive counts)
+		long rows = 0, cols = 0;
+		if (sscanf(pipeString + 5, "%ld %ld", &rows, &cols) == 2)
+			movePlaneWindow(rows, cols);
+	} else if(strncmp("follow on", pipeString, 9) == 0) {
+		setFollowLiveCells(1);
+	} else if(strncmp("follow off", pipeString, 10) == 0) {
+		setFollowLiveCells(0);
+	} else if(strncmp("reset", pipeString, 5) == 0) {
+		resetGrid();
+	} else if(strncmp("trace dump", pipeString, 10) == 0) {
+		writeTrace();
 	} else if(strncmp("end", pipeString, 3) == 0) {
 		exit(0);
 	}
@@ -367,46 +854,100 @@ void myKeyboard(unsigned char c, int x, int y) {
 
 		//	spacebar --> resets the grid
 		case ' ':
-			resetGrid();
+			//	applied between two generations, like the pipe commands
+			pushCommand("reset");
 			break;
 
 		//	'+' --> increase simulation speed
 		case '+':
-            if(applicationSpeed > 1)
-                applicationSpeed -= 10;
+			changeSpeed(SPEED_STEP);
 			break;
 
 		//	'-' --> reduce simulation speed
 		case '-':
-            if(applicationSpeed < 5000)
-                applicationSpeed += 10;
+			changeSpeed(1.0 / SPEED_STEP);
+			break;
+
+		//	'u' --> toggle unlimited speed
+		case 'u':
+			if (targetRate > 0.0) {
+				limitedRate = targetRate;
+				targetRate = 0.0;
+			}
+			else
+				targetRate = limitedRate;
 			break;
 
 		//	'1' --> apply Rule 1 (Game of Life: B23/S3)
+		//	(rules change between two generations, like the piped commands)
 		case '1':
-			rule = GAME_OF_LIFE_RULE;
+			pushCommand("rule 1");
 			break;
 
 		//	'2' --> apply Rule 2 (Coral: B3_S45678)
 		case '2':
-			rule = CORAL_GROWTH_RULE;
+			pushCommand("rule 2");
 			break;
 
 		//	'3' --> apply Rule 3 (Amoeba: B357/S1358)
 		case '3':
-			rule = AMOEBA_RULE;
+			pushCommand("rule 3");
 			break;
 
 		//	'4' --> apply Rule 4 (Maze: B3/S12345)
 		case '4':
-			rule = MAZE_RULE;
+			pushCommand("rule 4");
 			break;
 
 		//	'c' --> toggles on/off color mode
 		//	'b' --> toggles off/on color mode
 		case 'c':
 		case 'b':
-			colorMode = !colorMode;
+			setColorMode(!colorMode);
+			break;
+
+		//	'o' --> the plane's window follows the live cells, or stays where
+		//	it is panned
+		case 'o':
+			pushCommand(followLiveCells ? "follow off" : "follow on");
+			break;
+
+		//	'w' --> toggles on/off the wrapping around the edges (torus)
+		case 'w':
+			pushCommand(wrapFrame ? "wrap off" : "wrap on");
+			break;
+
+		//	'f' --> fast-forward 1000 generations, or cancel the fast-forward
+		case 'f':
+			pushCommand(fastForwardRemaining > 0 ? "ff cancel" : "ff 1000");
+			break;
+
+		//	'[' / ']' --> smaller / larger brush
+		case '[':
+			if (brushRadius > 0)
+				brushRadius--;
+			break;
+
+		case ']':
+			if (brushRadius < MAX_BRUSH_RADIUS)
+				brushRadius++;
+			break;
+
+		//	'p' --> next pattern stamped by a left click (after the last one:
+		//	back to painting)
+		case 'p':
+			stampIndex = (stampIndex + 1 < numStampPatterns()) ? stampIndex + 1 : -1;
+			break;
+
+		//	'z' / 'x' --> zoom in / out around the middle of the pane, 'h' --> whole grid
+		case 'z':
+		case 'x':
+			zoomAt(c == 'z' ? ZOOM_STEP : 1.0 / ZOOM_STEP, GRID_PANE_WIDTH / 2, GRID_PANE_HEIGHT / 2);
+			break;
+
+		case 'h':
+			zoomLevel = 1.0;
+			clampViewport();
 			break;
 
 		//	'l' --> toggles on/off grid line rendering
@@ -425,6 +966,33 @@ void myKeyboard(unsigned char c, int x, int y) {
 	glutPostRedisplay();
 }
 
+/*
+ *---------------------------------------------------------------------------
+ *	This callback function is called when a special key is pressed: the
+ *	arrows pan by an eighth of the pane
+ *---------------------------------------------------------------------------
+ */
+void mySpecialKeys(int key, int x, int y) {
+	switch (key) {
+		case GLUT_KEY_LEFT:
+			panBy(GRID_PANE_WIDTH / 8, 0);
+			break;
+		case GLUT_KEY_RIGHT:
+			panBy(-GRID_PANE_WIDTH / 8, 0);
+			break;
+		case GLUT_KEY_UP:
+			panBy(0, GRID_PANE_HEIGHT / 8);
+			break;
+		case GLUT_KEY_DOWN:
+			panBy(0, -GRID_PANE_HEIGHT / 8);
+			break;
+		default:
+			break;
+	}
+	glutSetWindow(gMainWindow);
+	glutPostRedisplay();
+}
+
 void myTimer(int value) {
 	//	value not used.  Warning suppression
 	(void) value;
@@ -435,7 +1003,7 @@ void myTimer(int value) {
     myDisplay();
     
 	//	And finally I perform the rendering
-	glutTimerFunc(100, myTimer, 0);
+	glutTimerFunc(REDRAW_INTERVAL_MS, myTimer, 0);
 }
 
 void myMenuHandler(int choice) {
@@ -490,7 +1058,9 @@ void initializeFrontEnd(int argc, char** argv,
 	glOrtho(0.0f, GRID_PANE_WIDTH, 0.0f, GRID_PANE_HEIGHT, -1, 1);
 	glClearColor(0.f, 0.f, 0.f, 1.f);
 	glutKeyboardFunc(myKeyboard);
+	glutSpecialFunc(mySpecialKeys);
 	glutMouseFunc(myGridPaneMouse);
+	glutMotionFunc(myGridPaneMotion);
 	glutDisplayFunc(gridDisplayCB);
 	
 	
@@ -504,6 +1074,6 @@ void initializeFrontEnd(int argc, char** argv,
 	glOrtho(0.0f, STATE_PANE_WIDTH, 0.0f, STATE_PANE_HEIGHT, -1, 1);
 	glClearColor(0.f, 0.f, 0.f, 1.f);
 	glutKeyboardFunc(myKeyboard);
-	glutMouseFunc(myGridPaneMouse);
+	glutMouseFunc(myStatePaneMouse);
 	glutDisplayFunc(stateDisplayCB);
 }
@@ -47,25 +47,44 @@ typedef enum ColorLabel {
 	NB_COLORS
 } ColorLabel;
 
+//	most states of a multi-state (Generations) rule: the colors past
+//	NB_COLORS are for their oldest dying states
+#define MAX_CELL_STATES		16
+
 
 #define	GAME_OF_LIFE_RULE 	1
 #define	CORAL_GROWTH_RULE 	2
 #define	AMOEBA_RULE 	  	3
 #define MAZE_RULE 			4
+//	any B/S or B/S/C rule, set with -rule or the "rule B.../S..." command
+#define CUSTOM_RULE			5
+//	radius-r Larger than Life rule ("rule R5,C2,M1,S34..58,B34..45,NM")
+#define LARGER_THAN_LIFE_RULE	6
+
 
+#include "perfCounters.h"
+#include "gridLayout.h"
+//	defined in genStats.h
+struct GenerationStats;
 
 //-----------------------------------------------------------------------------
 //	Function prototypes
 //-----------------------------------------------------------------------------
 
-void drawGrid(int**grid, unsigned int numRows, unsigned int numCols);
-void drawState(unsigned int numLiveThreads);
+void drawGrid(const Grid* grid, unsigned int numRows, unsigned int numCols);
+void drawState(unsigned int numLiveThreads, const PerfSummary* perf, const struct GenerationStats* stats);
 void initializeFrontEnd(int argc, char** argv, void (*gridCB)(void), void (*stateCB)(void));
 
 //	Functions implemented in main.c but called byt the glut callback functions
 void resetGrid(void);
+int setCustomRule(const char* text);
+unsigned int cellStateCount(void);
+int hexLattice(void);
+void setWrapFrame(int wrap);
 void oneGeneration();
 void pipeToCommand(char *pipeString);
+void movePlaneWindow(long rows, long cols);
+void setFollowLiveCells(int follow);
 
 
 #endif // GL_FRONT_END_H
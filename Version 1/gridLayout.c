@@ -0,0 +1,165 @@
+//
+//  gridLayout.c
+//  Cellular Automaton
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "gridLayout.h"
+
+static const char* LAYOUT_NAME[] = {"rows", "tiled"};
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+//	cells per row of band b, halo included
+int bandStride(const Grid* grid, int b) {
+	return grid->firstCol[b+1] - grid->firstCol[b] + 2;
+}
+
+//	band holding column j (the halo columns belong to the first & last bands)
+int bandOf(const Grid* grid, int j) {
+	//	all the bands but the last one are as wide as the first one
+	int b = (j < 0) ? 0 : j / grid->firstCol[1];
+	return (b < grid->numBands) ? b : grid->numBands - 1;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+Grid* createGrid(int numRows, int numCols, int bandCols) {
+	if (bandCols > numCols)
+		bandCols = numCols;
+	Grid* grid = (Grid*) calloc(1, sizeof(Grid));
+	if (grid == NULL)
+		return NULL;
+	grid->numRows = numRows;
+	grid->numCols = numCols;
+	grid->numBands = (numCols + bandCols - 1) / bandCols;
+	grid->firstCol = (int*) malloc((grid->numBands + 1)*sizeof(int));
+	//	(zeroed, so that destroyGrid can tell the bands that have rows)
+	grid->band = (int***) calloc(grid->numBands, sizeof(int**));
+	if (grid->firstCol == NULL || grid->band == NULL) {
+		destroyGrid(grid);
+		return NULL;
+	}
+	for (int b=0; b<=grid->numBands; b++)
+		grid->firstCol[b] = (b < grid->numBands) ? b*bandCols : numCols;
+
+	//	one allocation: band b starts after the (numRows+2) x stride cells of
+	//	the bands before it, which is always past its first column number, so
+	//	that its rows' column-0 pointers stay inside the allocation
+	size_t size = 0;
+	for (int b=0; b<grid->numBands; b++)
+		size += (size_t) (numRows+2)*bandStride(grid, b);
+	grid->cells = (int*) calloc(size, sizeof(int));
+	if (grid->cells == NULL) {
+		destroyGrid(grid);
+		return NULL;
+	}
+	int* base = grid->cells;
+	for (int b=0; b<grid->numBands; b++) {
+		int stride = bandStride(grid, b);
+		int** rows = (int**) malloc((numRows+2)*sizeof(int*));
+		if (rows == NULL) {
+			destroyGrid(grid);
+			return NULL;
+		}
+		rows++;
+		for (int i=-1; i<=numRows; i++)
+			rows[i] = base + (size_t) (i+1)*stride + 1 - grid->firstCol[b];
+		grid->band[b] = rows;
+		base += (size_t) (numRows+2)*stride;
+	}
+	return grid;
+}
+
+void destroyGrid(Grid* grid) {
+	if (grid == NULL)
+		return;
+	//	(a grid that ran out of memory may have rows for only some of its bands)
+	if (grid->band != NULL) {
+		for (int b=0; b<grid->numBands; b++) {
+			if (grid->band[b] != NULL)
+				free(grid->band[b] - 1);
+		}
+	}
+	free(grid->band);
+	free(grid->firstCol);
+	free(grid->cells);
+	free(grid);
+}
+
+int* gridCell(const Grid* grid, int i, int j) {
+	return grid->band[bandOf(grid, j)][i] + j;
+}
+
+void setGridHaloRows(Grid* grid, int torus) {
+	int numRows = grid->numRows;
+	for (int b=0; b<grid->numBands; b++) {
+		int** rows = grid->band[b];
+		int stride = bandStride(grid, b);
+		//	row 0 & numRows-1 always point to their own cells
+		if (torus) {
+			rows[-1] = rows[numRows-1];
+			rows[numRows] = rows[0];
+		} else {
+			rows[-1] = rows[0] - stride;
+			rows[numRows] = rows[numRows-1] + stride;
+		}
+	}
+}
+
+void shareBandEdges(const Grid* grid, int b, int row, int wrap) {
+	const int* cells = grid->band[b][row];
+	int first = grid->firstCol[b], last = grid->firstCol[b+1] - 1;
+	if (b > 0)
+		grid->band[b-1][row][first] = cells[first];
+	else if (wrap)
+		grid->band[grid->numBands-1][row][grid->numCols] = cells[0];
+	if (b < grid->numBands-1)
+		grid->band[b+1][row][last] = cells[last];
+	else if (wrap)
+		grid->band[0][row][-1] = cells[grid->numCols-1];
+}
+
+void refreshGridEdges(const Grid* grid, int wrap) {
+	for (int i=0; i<grid->numRows; i++) {
+		for (int b=0; b<grid->numBands; b++)
+			shareBandEdges(grid, b, i, wrap);
+	}
+}
+
+void copyGridRow(const Grid* grid, int i, int* cells) {
+	for (int b=0; b<grid->numBands; b++) {
+		const int* row = grid->band[b][i];
+		int first = (b == 0) ? -1 : grid->firstCol[b];
+		int end = (b == grid->numBands-1) ? grid->numCols+1 : grid->firstCol[b+1];
+		memcpy(cells + first + 1, row + first, (end - first)*sizeof(int));
+	}
+}
+
+void copyIntoGridRow(const Grid* grid, int i, const int* cells) {
+	//	the bands' halo columns too
+	for (int b=0; b<grid->numBands; b++) {
+		int first = grid->firstCol[b] - 1;
+		int end = grid->firstCol[b+1] + 1;
+		memcpy(grid->band[b][i] + first, cells + first + 1, (end - first)*sizeof(int));
+	}
+}
+
+int parseGridLayout(const char* text, GridLayout* layout) {
+	for (int k=LAYOUT_ROWS; k<=LAYOUT_TILED; k++) {
+		if (strcmp(text, LAYOUT_NAME[k]) == 0) {
+			*layout = (GridLayout) k;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+const char* gridLayoutName(GridLayout layout) {
+	return LAYOUT_NAME[layout];
+}
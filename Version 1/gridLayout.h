@@ -0,0 +1,69 @@
+//
+//  gridLayout.h
+//  Cellular Automaton
+//
+//  How the cells of a grid are stored.  In the row layout, the rows above
+//  & below a cell are a whole row (numCols+2 cells) away: on wide grids,
+//  the three rows a generation reads are evicted from the caches before
+//  the next row needs them again.  The tiled layout cuts the grid into
+//  bands of columns (tiles as tall as the grid) stored one after the other,
+//  each with its own halo, and a generation sweeps down one band at a time:
+//  a band's rows are short enough for the rows being read to stay in L1.
+//
+//  The rows of a band are indexed with the grid's own column numbers, so
+//  band[b][i][j-1] to band[b][i][j+1] are cells for any column j of the
+//  band, as on the row layout (which is a single band).
+//
+
+#ifndef GRID_LAYOUT_H
+#define GRID_LAYOUT_H
+
+//	default width of the tiled layout's bands (2 KB of cells per row)
+#define DEFAULT_TILE_COLS	512
+#define MIN_TILE_COLS		16
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef enum GridLayout {
+	LAYOUT_ROWS = 0,
+	LAYOUT_TILED
+} GridLayout;
+
+typedef struct Grid {
+	int numRows, numCols;
+	int numBands;
+	//	band b holds columns firstCol[b] to firstCol[b+1]-1 (numBands+1 entries)
+	int* firstCol;
+	//	row scaffold of each band: band[b][i][j] is valid for rows -1 to
+	//	numRows and columns firstCol[b]-1 to firstCol[b+1] (halo included)
+	int*** band;
+	//	all the cells, band after band
+	int* cells;
+} Grid;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	All cells dead; bandCols >= numCols gives the row layout.  NULL if out of memory
+Grid* createGrid(int numRows, int numCols, int bandCols);
+void destroyGrid(Grid* grid);
+//	Cell (i, j), for i from -1 to numRows and j from -1 to numCols
+int* gridCell(const Grid* grid, int i, int j);
+//	torus = 1 --> each band's halo rows are its last & first rows themselves,
+//	else the band's own halo rows (dead, or written by copyIntoGridRow)
+void setGridHaloRows(Grid* grid, int torus);
+//	Copies the first & last cells of a band's row into the halos of the bands
+//	next to it (wrap = 1 --> the grid's edge cells go into the opposite halo)
+void shareBandEdges(const Grid* grid, int b, int row, int wrap);
+//	Same, for every row & band: after cells were written outside a generation
+void refreshGridEdges(const Grid* grid, int wrap);
+//	Row i (columns -1 to numCols) as numCols+2 contiguous cells, and back
+void copyGridRow(const Grid* grid, int i, int* cells);
+void copyIntoGridRow(const Grid* grid, int i, const int* cells);
+int parseGridLayout(const char* text, GridLayout* layout);
+const char* gridLayoutName(GridLayout layout);
+
+#endif // GRID_LAYOUT_H
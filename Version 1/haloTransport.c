@@ -0,0 +1,27 @@
+//
+//  haloTransport.c
+//  Cellular Automaton
+//
+
+#include <string.h>
+#include "haloTransport.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+//	new transports go here
+const HaloTransport* TRANSPORTS[] = {&SHM_TRANSPORT};
+const int NUM_TRANSPORTS = sizeof(TRANSPORTS) / sizeof(TRANSPORTS[0]);
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+const HaloTransport* findTransport(const char* name) {
+	for (int k=0; k<NUM_TRANSPORTS; k++) {
+		if (strcmp(name, TRANSPORTS[k]->name) == 0)
+			return TRANSPORTS[k];
+	}
+	return NULL;
+}
@@ -0,0 +1,46 @@
+//
+//  haloTransport.h
+//  Cellular Automaton
+//
+//  When the grid is split between several processes, each owning a band of
+//  rows, the processes swap the rows along their common edges (the "halo")
+//  once per generation.  A transport is a table of functions, so that other
+//  ones (MPI, sockets...) can be added next to the shared-memory one
+//  without touching the simulation.
+//
+
+#ifndef HALO_TRANSPORT_H
+#define HALO_TRANSPORT_H
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef struct HaloTransport {
+	const char* name;
+	//	called by the launcher before starting the processes and after they
+	//	are all done; create returns 0 on failure
+	int (*create)(int numRanks, int rowLength);
+	void (*destroy)(void);
+	//	called by each process (rank 0 owns the top rows); on a periodic grid
+	//	the first & last ranks are neighbors too.  Returns 0 on failure
+	int (*attach)(int rank, int numRanks, int rowLength, int periodic);
+	//	Publishes this process' first & last rows of the given generation,
+	//	then blocks until the neighbors' edge rows of that generation have
+	//	been copied into the halo rows (left alone where there is no neighbor)
+	void (*exchange)(const int* firstRow, const int* lastRow,
+					 int* haloAbove, int* haloBelow, unsigned long generation);
+	void (*detach)(void);
+} HaloTransport;
+
+//	Shared memory segment + futex wake-ups (all processes on the same host)
+extern const HaloTransport SHM_TRANSPORT;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	NULL if there is no transport by that name
+const HaloTransport* findTransport(const char* name);
+
+#endif // HALO_TRANSPORT_H
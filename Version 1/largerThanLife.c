@@ -0,0 +1,172 @@
+//
+//  largerThanLife.c
+//  Cellular Automaton
+//
+//  A band of rows is summed from top to bottom: the rows leaving the box
+//  are subtracted from the column sums, and the one entering it is added.
+//  Each band also sums the r rows above and below it, so threads never
+//  wait for each other's sums.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "largerThanLife.h"
+#include "poolAlloc.h"
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+//	reads "lo..hi"; returns the first char after it, or NULL
+const char* parseRange(const char* text, int* low, int* high) {
+	int length;
+	if (sscanf(text, "%d..%d%n", low, high, &length) != 2 || *low < 0 || *low > *high)
+		return NULL;
+	return text + length;
+}
+
+int slotOf(const BoxSums* sums, int row) {
+	int slots = 2*sums->rule->radius + 1;
+	return ((row % slots) + slots) % slots;
+}
+
+//	sliding window along the row: sum of the 2r+1 cells around each cell
+void horizontalSums(BoxSums* sums, int row, int* out) {
+	int radius = sums->rule->radius, numCols = sums->numCols;
+	if (row < 0 || row >= sums->numRows) {
+		if (!sums->wrap) {
+			memset(out, 0, numCols*sizeof(int));
+			return;
+		}
+		row = (row + sums->numRows) % sums->numRows;
+	}
+
+	int* alive = sums->alive + radius;
+	for (int b=0; b<sums->grid->numBands; b++) {
+		const int* cells = sums->grid->band[b][row];
+		int first = sums->grid->firstCol[b], end = sums->grid->firstCol[b+1];
+		if (sums->rule->states > 2) {
+			for (int j=first; j<end; j++)
+				alive[j] = (cells[j] == 1);
+		} else {
+			for (int j=first; j<end; j++)
+				alive[j] = (cells[j] != 0);
+		}
+	}
+	for (int t=1; t<=radius; t++) {
+		alive[-t] = sums->wrap ? alive[numCols-t] : 0;
+		alive[numCols-1+t] = sums->wrap ? alive[t-1] : 0;
+	}
+
+	int sum = 0;
+	for (int j=-radius; j<=radius; j++)
+		sum += alive[j];
+	out[0] = sum;
+	for (int j=1; j<numCols; j++) {
+		sum += alive[j+radius] - alive[j-radius-1];
+		out[j] = sum;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int parseLtlRule(const char* text, LtlRule* rule) {
+	int haveRadius = 0, haveBirth = 0, haveSurvival = 0;
+	rule->states = 2;
+	rule->middle = 0;
+	while (*text != '\0') {
+		char letter = *text++;
+		int length = 0;
+		if (letter == 'R' && sscanf(text, "%d%n", &rule->radius, &length) == 1)
+			haveRadius = 1;
+		else if (letter == 'C' && sscanf(text, "%d%n", &rule->states, &length) == 1) {
+			//	C0 & C1 also mean two states
+			if (rule->states < 2)
+				rule->states = 2;
+		}
+		else if (letter == 'M' && (*text == '0' || *text == '1')) {
+			rule->middle = (*text == '1');
+			length = 1;
+		}
+		else if (letter == 'S' || letter == 'B') {
+			const char* end = (letter == 'S') ? parseRange(text, &rule->survivalLow, &rule->survivalHigh) :
+												parseRange(text, &rule->birthLow, &rule->birthHigh);
+			if (end == NULL)
+				return 0;
+			length = (int) (end - text);
+			haveSurvival |= (letter == 'S');
+			haveBirth |= (letter == 'B');
+		}
+		//	only the box neighborhood for now
+		else if (letter == 'N' && *text == 'M')
+			length = 1;
+		else
+			return 0;
+		text += length;
+		if (*text == ',')
+			text++;
+	}
+	return haveRadius && haveBirth && haveSurvival &&
+		   rule->radius >= 1 && rule->radius <= LTL_MAX_RADIUS;
+}
+
+void ltlRuleName(const LtlRule* rule, char* name) {
+	snprintf(name, LTL_NAME_LENGTH, "R%d,C%d,M%d,S%d..%d,B%d..%d,NM", rule->radius, rule->states,
+			 rule->middle, rule->survivalLow, rule->survivalHigh, rule->birthLow, rule->birthHigh);
+}
+
+void startBoxSums(BoxSums* sums, const LtlRule* rule, const Grid* grid, int firstRow,
+				  int numRows, int numCols, int wrap) {
+	int slots = 2*rule->radius + 1;
+	if (slots > sums->capacityRows || numCols > sums->capacityCols) {
+		freeBoxSums(sums);
+		sums->rowSums = (int*) poolAlloc((size_t) slots*numCols*sizeof(int));
+		sums->counts = (int*) poolAlloc(numCols*sizeof(int));
+		sums->alive = (int*) poolAlloc((numCols + 2*LTL_MAX_RADIUS)*sizeof(int));
+		sums->capacityRows = slots;
+		sums->capacityCols = numCols;
+	}
+	sums->rule = rule;
+	sums->grid = grid;
+	sums->numRows = numRows;
+	sums->numCols = numCols;
+	sums->wrap = wrap;
+	sums->row = firstRow;
+
+	//	all the box of the first row but its last row, which the first call
+	//	to nextBoxSums() adds (after removing the empty slot it goes into)
+	memset(sums->counts, 0, numCols*sizeof(int));
+	memset(sums->rowSums + (size_t) slotOf(sums, firstRow + rule->radius)*numCols, 0,
+		   numCols*sizeof(int));
+	for (int k=firstRow-rule->radius; k<firstRow+rule->radius; k++) {
+		int* rowSum = sums->rowSums + (size_t) slotOf(sums, k)*numCols;
+		horizontalSums(sums, k, rowSum);
+		for (int j=0; j<numCols; j++)
+			sums->counts[j] += rowSum[j];
+	}
+}
+
+const int* nextBoxSums(BoxSums* sums) {
+	int numCols = sums->numCols;
+	//	the row entering the box takes the slot of the one leaving it
+	int entering = sums->row + sums->rule->radius;
+	int* rowSum = sums->rowSums + (size_t) slotOf(sums, entering)*numCols;
+	for (int j=0; j<numCols; j++)
+		sums->counts[j] -= rowSum[j];
+	horizontalSums(sums, entering, rowSum);
+	for (int j=0; j<numCols; j++)
+		sums->counts[j] += rowSum[j];
+	sums->row++;
+	return sums->counts;
+}
+
+void freeBoxSums(BoxSums* sums) {
+	poolFree(sums->rowSums);
+	poolFree(sums->counts);
+	poolFree(sums->alive);
+	sums->rowSums = sums->counts = sums->alive = NULL;
+	sums->capacityRows = sums->capacityCols = 0;
+}
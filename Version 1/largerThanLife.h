@@ -0,0 +1,75 @@
+//
+//  largerThanLife.h
+//  Cellular Automaton
+//
+//  Larger than Life rules: the neighborhood is the (2r+1) x (2r+1) box
+//  around a cell, and a cell is born or survives when the number of live
+//  cells in that box falls in a range.  Written like Golly does:
+//		R5,C2,M1,S34..58,B34..45,NM		(Bosco's rule)
+//	R: radius (1 - 10), C: number of states (above 2, dying states as in
+//	Generations rules), M1: the cell counts itself, NM: box (Moore) neighborhood.
+//
+//  The counts come from box sums, computed as a sliding window along each
+//  row, then as a sliding window down the columns: 2 additions and 2
+//  subtractions per cell, whatever the radius.
+//
+
+#ifndef LARGER_THAN_LIFE_H
+#define LARGER_THAN_LIFE_H
+
+#include "gridLayout.h"
+
+#define LTL_MAX_RADIUS	10
+//	length of a rule written as text
+#define LTL_NAME_LENGTH	64
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef struct LtlRule {
+	int radius;
+	int states;
+	//	1 --> the cell itself is in its neighborhood
+	int middle;
+	//	ranges of live cells in the neighborhood (bounds included)
+	int birthLow, birthHigh;
+	int survivalLow, survivalHigh;
+} LtlRule;
+
+//	Box sums of a band of rows, computed one row at a time.  Each thread has
+//	its own; the buffers only grow, when the radius or the width do.
+typedef struct BoxSums {
+	const LtlRule* rule;
+	const Grid* grid;
+	int numRows, numCols;
+	int wrap;
+	//	next row to be returned
+	int row;
+	//	horizontal sums of the last 2r+1 rows, row k in slot k % (2r+1)
+	int* rowSums;
+	//	vertical sums of those: the counts of the row being returned
+	int* counts;
+	//	which cells of a row are alive, with r cells on each side
+	int* alive;
+	int capacityRows, capacityCols;
+} BoxSums;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	Parses "R5,C2,M1,S34..58,B34..45,NM"; returns 0 if the text is not such a rule
+int parseLtlRule(const char* text, LtlRule* rule);
+//	name must hold LTL_NAME_LENGTH chars
+void ltlRuleName(const LtlRule* rule, char* name);
+
+//	Prepares the sums of rows [firstRow, ...) of a numRows x numCols grid
+//	(which is wrapped around, or surrounded by dead cells)
+void startBoxSums(BoxSums* sums, const LtlRule* rule, const Grid* grid, int firstRow,
+				  int numRows, int numCols, int wrap);
+//	Number of live cells in the box around each cell of the next row
+const int* nextBoxSums(BoxSums* sums);
+void freeBoxSums(BoxSums* sums);
+
+#endif // LARGER_THAN_LIFE_H
@@ -0,0 +1,757 @@
+//
+//  lifeEngine.c
+//  Cellular Automaton
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "lifeEngine.h"
+#include "genStats.h"
+#include "poolAlloc.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+//	the rules of gl_frontEnd.h, in the same order
+const LifeRule BUILT_IN_RULES[] = {
+	{.birth = 1<<3, .survival = (1<<2) | (1<<3),									//	Life: B3/S23
+	 .states = 2, .neighborhood = NEIGHBORHOOD_MOORE},
+	{.birth = 1<<3, .survival = (1<<4) | (1<<5) | (1<<6) | (1<<7) | (1<<8),			//	Coral: B3/S45678
+	 .states = 2, .neighborhood = NEIGHBORHOOD_MOORE},
+	{.birth = (1<<3) | (1<<5) | (1<<7), .survival = (1<<1) | (1<<3) | (1<<5) | (1<<8),	//	Amoeba: B357/S1358
+	 .states = 2, .neighborhood = NEIGHBORHOOD_MOORE},
+	{.birth = 1<<3, .survival = (1<<1) | (1<<2) | (1<<3) | (1<<4) | (1<<5),			//	Maze: B3/S12345
+	 .states = 2, .neighborhood = NEIGHBORHOOD_MOORE}
+};
+
+const char* BOUNDARY_NAME[] = {"dead", "wrap"};
+
+//	letter written after the rule, and most live neighbors, of each Neighborhood
+const char NEIGHBORHOOD_LETTER[] = {'\0', 'V', 'H'};
+const int NEIGHBORHOOD_SIZE[] = {8, 4, 6};
+
+//	Hensel notation: the letters of the configurations of 1 to 4 live
+//	neighbors, and one of each (as a 3x3 index); the other ones are their
+//	rotations & reflections.  For 5 to 7 live neighbors, the same letters
+//	are the same shapes drawn with the dead neighbors.
+const char* HENSEL_LETTERS[5] = {"", "ce", "ceaikn", "ceaiknjqry", "ceaiknjqrytwz"};
+const uint16_t HENSEL_SHAPES[5][13] = {
+	{0},
+	{1, 2},
+	{5, 10, 3, 40, 33, 68},
+	{69, 42, 11, 7, 98, 13, 14, 70, 41, 97},
+	{325, 170, 15, 45, 99, 71, 106, 102, 43, 101, 105, 78, 108}
+};
+//	the 8 neighbors in a 3x3 index
+#define NEIGHBOR_BITS	0x1EF
+#define CENTER_BIT		0x10
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+//	splitmix64 generator: small state, so every run gets its own
+uint64_t nextRandom(uint64_t* state) {
+	*state += 0x9E3779B97F4A7C15ull;
+	return mixHash(*state);
+}
+
+//	a 3x3 index rotated by a quarter turn (t & 3) times, after a mirror image if t & 4
+unsigned int transformIndex(unsigned int index, int t) {
+	unsigned int result = 0;
+	for (int p=0; p<9; p++) {
+		if (!(index & (1 << p)))
+			continue;
+		int row = p / 3, col = p % 3;
+		if (t & 4)
+			col = 2 - col;
+		for (int k=0; k<(t & 3); k++) {
+			int turned = col;
+			col = 2 - row;
+			row = turned;
+		}
+		result |= 1 << (3*row + col);
+	}
+	return result;
+}
+
+//	Hensel letter of a configuration of the neighbors (center bit ignored),
+//	as a position in HENSEL_LETTERS; -1 for 0 & 8 live neighbors
+int henselLetter(unsigned int index) {
+	index &= NEIGHBOR_BITS;
+	int count = __builtin_popcount(index);
+	if (count == 0 || count == 8)
+		return -1;
+	int shapes = count;
+	if (count > 4) {
+		shapes = 8 - count;
+		index = ~index & NEIGHBOR_BITS;
+	}
+	for (int k=0; HENSEL_LETTERS[shapes][k] != '\0'; k++) {
+		for (int t=0; t<8; t++) {
+			if (transformIndex(HENSEL_SHAPES[shapes][k], t) == index)
+				return k;
+		}
+	}
+	return -1;
+}
+
+const char* countLetters(int count) {
+	return HENSEL_LETTERS[count > 4 ? 8 - count : count];
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Reads counts 0-8, each followed or not by Hensel letters: "2ak" (those
+ *	configurations only) or "2-a" (all but those).  The configurations are
+ *	added to the transitions of the cells whose center bit is given.
+ *	Returns the first char after them, or NULL if the letters are wrong.
+ *---------------------------------------------------------------------------
+ */
+const char* parseCounts(const char* text, unsigned int center, uint64_t* transitions) {
+	while (*text >= '0' && *text <= '8') {
+		int count = *text++ - '0';
+		const char* letters = countLetters(count);
+		int negate = (*text == '-');
+		if (negate)
+			text++;
+		unsigned int chosen = 0;
+		const char* at;
+		while (*text != '\0' && (at = strchr(letters, *text)) != NULL) {
+			chosen |= 1u << (at - letters);
+			text++;
+		}
+		if (negate && chosen == 0)
+			return NULL;
+		for (unsigned int index=0; index<NEIGHBORHOOD_INDICES; index++) {
+			if ((index & CENTER_BIT) != center || __builtin_popcount(index & NEIGHBOR_BITS) != count)
+				continue;
+			int letter = henselLetter(index);
+			int inRule = (chosen == 0) || (((chosen >> letter) & 1) != negate);
+			if (inRule)
+				transitions[index / 64] |= 1ull << (index % 64);
+		}
+	}
+	return text;
+}
+
+int inTransitions(const uint64_t* transitions, unsigned int index) {
+	return (transitions[index / 64] >> (index % 64)) & 1;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Sets birth & survival to the counts whose configurations all give a
+ *	live cell, and isotropic if some counts are left out.
+ *---------------------------------------------------------------------------
+ */
+void summarizeTransitions(LifeRule* rule) {
+	rule->birth = rule->survival = 0;
+	rule->isotropic = 0;
+	for (unsigned int center=0; center<=CENTER_BIT; center+=CENTER_BIT) {
+		int inRule[9] = {0}, total[9] = {0};
+		for (unsigned int index=center; index<NEIGHBORHOOD_INDICES; index++) {
+			if ((index & CENTER_BIT) != center)
+				continue;
+			int count = __builtin_popcount(index & NEIGHBOR_BITS);
+			total[count]++;
+			inRule[count] += inTransitions(rule->transitions, index);
+		}
+		for (int count=0; count<=8; count++) {
+			if (inRule[count] == total[count]) {
+				if (center)
+					rule->survival |= 1 << count;
+				else
+					rule->birth |= 1 << count;
+			}
+			else if (inRule[count] > 0)
+				rule->isotropic = 1;
+		}
+	}
+}
+
+//	writes counts (and letters) of a B or S part; returns the end of the text
+char* writeCounts(const LifeRule* rule, unsigned int center, uint16_t mask, char* name) {
+	for (int count=0; count<=8; count++) {
+		if (mask & (1 << count)) {
+			*name++ = '0' + count;
+			continue;
+		}
+		if (!rule->isotropic)
+			continue;
+		//	letters whose configurations are in the rule, or not
+		const char* letters = countLetters(count);
+		unsigned int in = 0, out = 0;
+		for (unsigned int index=center; index<NEIGHBORHOOD_INDICES; index++) {
+			if ((index & CENTER_BIT) != center || __builtin_popcount(index & NEIGHBOR_BITS) != count)
+				continue;
+			if (inTransitions(rule->transitions, index))
+				in |= 1u << henselLetter(index);
+			else
+				out |= 1u << henselLetter(index);
+		}
+		if (in == 0)
+			continue;
+		*name++ = '0' + count;
+		int negate = __builtin_popcount(in) > __builtin_popcount(out);
+		if (negate)
+			*name++ = '-';
+		for (int k=0; letters[k] != '\0'; k++) {
+			if (((negate ? out : in) >> k) & 1)
+				*name++ = letters[k];
+		}
+	}
+	return name;
+}
+
+uint64_t* rowPlanes(const LifeEngine* engine, uint64_t* cells, int row) {
+	return cells + (size_t) row * engine->numPlanes * engine->words;
+}
+
+//	the alive bits of a row (or of the dead row, outside an unwrapped grid)
+const uint64_t* aliveRow(const LifeEngine* engine, int row) {
+	if (row < 0 || row >= engine->rows) {
+		if (engine->boundary == BOUNDARY_DEAD)
+			return engine->deadRow;
+		row = (row + engine->rows) % engine->rows;
+	}
+	if (engine->numPlanes == 1)
+		return rowPlanes(engine, engine->cells, row);
+	return engine->alive + (size_t) row * engine->words;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	A row's cells shifted by one column, so that bit c of word w holds the
+ *	west (c-1) or east (c+1) neighbor of the cell in bit c.  Across the left
+ *	& right edges, the neighbor is dead or the cell from the other side.
+ *---------------------------------------------------------------------------
+ */
+uint64_t westWord(const LifeEngine* engine, const uint64_t* row, int w) {
+	if (w > 0)
+		return (row[w] << 1) | (row[w-1] >> 63);
+	uint64_t wrapped = 0;
+	if (engine->boundary == BOUNDARY_WRAP)
+		wrapped = (row[engine->words-1] >> ((engine->cols-1) & 63)) & 1;
+	return (row[0] << 1) | wrapped;
+}
+
+uint64_t eastWord(const LifeEngine* engine, const uint64_t* row, int w) {
+	if (w < engine->words-1)
+		return (row[w] >> 1) | (row[w+1] << 63);
+	uint64_t wrapped = 0;
+	if (engine->boundary == BOUNDARY_WRAP)
+		wrapped = (row[0] & 1) << ((engine->cols-1) & 63);
+	return (row[w] >> 1) | wrapped;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Same row hash as rowGeneration() in main.c: which cells are not dead,
+ *	64 at a time.  With dying states, every plane is mixed in too, so that
+ *	a cycle is only found when the states repeat.
+ *---------------------------------------------------------------------------
+ */
+uint64_t rowHash(const LifeEngine* engine, const uint64_t* planes, int row) {
+	int words = engine->words, fullWords = engine->cols / 64;
+	//	(a single plane is the liveness itself)
+	int statePlanes = (engine->numPlanes > 1) ? engine->numPlanes : 0;
+	uint64_t hash = 0, rest = 0;
+	for (int w=0; w<words; w++) {
+		uint64_t notDead = 0;
+		for (int p=0; p<engine->numPlanes; p++)
+			notDead |= planes[p*words + w];
+		if (w < fullWords)
+			hash = mixHash(hash ^ notDead);
+		else
+			rest = notDead;
+		for (int p=0; p<statePlanes; p++)
+			hash = mixHash(hash ^ planes[p*words + w]);
+	}
+	return mixHash(hash ^ rest ^ (0x9E3779B97F4A7C15ull * (row + 1)));
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Number of live neighbors of the 64 cells of word w, as 4 bit planes
+ *	n[3] n[2] n[1] n[0], one kernel per neighborhood.  Only the neighbors
+ *	the neighborhood uses are shifted & added, so the von Neumann and hex
+ *	kernels are cheaper than the Moore one.
+ *---------------------------------------------------------------------------
+ */
+//	the 8 neighbors, in the order of IsotropicTest configs: nb[7] NW ... nb[0] SE
+void mooreNeighbors(const LifeEngine* engine, const uint64_t* up, const uint64_t* mid,
+					const uint64_t* down, int w, uint64_t* nb) {
+	nb[7] = westWord(engine, up, w);
+	nb[6] = up[w];
+	nb[5] = eastWord(engine, up, w);
+	nb[4] = westWord(engine, mid, w);
+	nb[3] = eastWord(engine, mid, w);
+	nb[2] = westWord(engine, down, w);
+	nb[1] = down[w];
+	nb[0] = eastWord(engine, down, w);
+}
+
+void mooreCounts(const uint64_t* nb, uint64_t* n) {
+	uint64_t a = nb[7], b = nb[6], c = nb[5];
+	uint64_t d = nb[4], e = nb[3];
+	uint64_t f = nb[2], g = nb[1], h = nb[0];
+
+	//	rows above & below: 0-3 each, middle row: 0-2
+	uint64_t up0 = a ^ b ^ c, up1 = (a & b) | (c & (a ^ b));
+	uint64_t down0 = f ^ g ^ h, down1 = (f & g) | (h & (f ^ g));
+	uint64_t mid0 = d ^ e, mid1 = d & e;
+	//	up + down: 0-6
+	uint64_t t0 = up0 ^ down0, k0 = up0 & down0;
+	uint64_t t1 = up1 ^ down1 ^ k0, t2 = (up1 & down1) | (k0 & (up1 ^ down1));
+	//	+ middle: 0-8
+	uint64_t j0 = t0 & mid0, j1 = (t1 & mid1) | (j0 & (t1 ^ mid1));
+	n[0] = t0 ^ mid0;
+	n[1] = t1 ^ mid1 ^ j0;
+	n[2] = t2 ^ j1;
+	n[3] = t2 & j1;
+}
+
+void vonNeumannCounts(const LifeEngine* engine, const uint64_t* up, const uint64_t* mid,
+					  const uint64_t* down, int w, uint64_t* n) {
+	uint64_t b = up[w], g = down[w];
+	uint64_t d = westWord(engine, mid, w), e = eastWord(engine, mid, w);
+
+	//	up + down: 0-2, west + east: 0-2, then the sum: 0-4
+	uint64_t s0 = b ^ g, s1 = b & g;
+	uint64_t m0 = d ^ e, m1 = d & e;
+	uint64_t k0 = s0 & m0;
+	n[0] = s0 ^ m0;
+	n[1] = s1 ^ m1 ^ k0;
+	n[2] = (s1 & m1) | (k0 & (s1 ^ m1));
+	n[3] = 0;
+}
+
+//	the rows above & below are half a cell to the left of an odd row, to the
+//	right of an even one: 2 of their cells touch the cell
+void hexCounts(const LifeEngine* engine, const uint64_t* up, const uint64_t* mid,
+			   const uint64_t* down, int w, int oddRow, uint64_t* n) {
+	uint64_t a, b, f, g;
+	if (oddRow) {
+		a = up[w];
+		b = eastWord(engine, up, w);
+		f = down[w];
+		g = eastWord(engine, down, w);
+	} else {
+		a = westWord(engine, up, w);
+		b = up[w];
+		f = westWord(engine, down, w);
+		g = down[w];
+	}
+	uint64_t d = westWord(engine, mid, w), e = eastWord(engine, mid, w);
+
+	//	each pair: 0-2
+	uint64_t up0 = a ^ b, up1 = a & b;
+	uint64_t down0 = f ^ g, down1 = f & g;
+	uint64_t mid0 = d ^ e, mid1 = d & e;
+	//	up + down: 0-4
+	uint64_t k0 = up0 & down0;
+	uint64_t t0 = up0 ^ down0, t1 = up1 ^ down1 ^ k0, t2 = (up1 & down1) | (k0 & (up1 ^ down1));
+	//	+ middle: 0-6
+	uint64_t j0 = t0 & mid0, j1 = (t1 & mid1) | (j0 & (t1 ^ mid1));
+	n[0] = t0 ^ mid0;
+	n[1] = t1 ^ mid1 ^ j0;
+	n[2] = t2 ^ j1;
+	n[3] = 0;
+}
+
+//	the cells among the 64 that have count live neighbors
+uint64_t countIs(const uint64_t* n, int count) {
+	return ((count & 1) ? n[0] : ~n[0]) & ((count & 2) ? n[1] : ~n[1]) &
+		   ((count & 4) ? n[2] : ~n[2]) & ((count & 8) ? n[3] : ~n[3]);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	The non-totalistic counts of a rule, bit-parallel: among the cells with
+ *	the right count, a configuration is found by checking only its live
+ *	neighbors (or its dead ones, when there are fewer), since the count
+ *	already says that no other neighbor is alive.  A test looks for the
+ *	fewer of the configurations that give a live cell and those that don't,
+ *	so a rule like B2-a costs 8 configurations of 2 ANDs each.
+ *---------------------------------------------------------------------------
+ */
+void compileIsotropicTests(LifeEngine* engine) {
+	engine->numIsotropicTests = 0;
+	const LifeRule* rule = &engine->rule;
+	if (!rule->isotropic)
+		return;
+	for (int alive=0; alive<=1; alive++) {
+		uint16_t whole = alive ? rule->survival : rule->birth;
+		for (int count=0; count<=8; count++) {
+			if (whole & (1 << count))
+				continue;
+			uint8_t in[70], out[70];
+			int numIn = 0, numOut = 0;
+			for (unsigned int index=0; index<NEIGHBORHOOD_INDICES; index++) {
+				if ((int) ((index & CENTER_BIT) != 0) != alive ||
+					__builtin_popcount(index & NEIGHBOR_BITS) != count)
+					continue;
+				//	the 8 neighbor bits next to each other
+				uint8_t config = (uint8_t) (((index >> 5) << 4) | (index & 15));
+				if (inTransitions(rule->transitions, index))
+					in[numIn++] = config;
+				else
+					out[numOut++] = config;
+			}
+			if (numIn == 0)
+				continue;
+			IsotropicTest* test = engine->isotropicTests + engine->numIsotropicTests++;
+			test->alive = (uint8_t) alive;
+			test->count = (uint8_t) count;
+			test->negate = (numOut < numIn);
+			test->checks = (uint8_t) (count <= 4 ? count : 8 - count);
+			test->numConfigs = (uint8_t) (test->negate ? numOut : numIn);
+			for (int c=0; c<test->numConfigs; c++) {
+				uint8_t config = test->negate ? out[c] : in[c];
+				//	fewer live than dead neighbors: check the live ones
+				if (count > 4)
+					config = (uint8_t) ~config;
+				int k = 0;
+				for (int position=0; position<8; position++) {
+					if ((config >> position) & 1)
+						test->positions[c][k++] = (uint8_t) position;
+				}
+			}
+		}
+	}
+}
+
+void isotropicMasks(const LifeEngine* engine, const uint64_t* nb, const uint64_t* n,
+					uint64_t* born, uint64_t* survive) {
+	uint64_t dead[8];
+	for (int position=0; position<8; position++)
+		dead[position] = ~nb[position];
+	for (int k=0; k<engine->numIsotropicTests; k++) {
+		const IsotropicTest* test = engine->isotropicTests + k;
+		const uint64_t* checked = (test->count <= 4) ? nb : dead;
+		const uint8_t (*positions)[4] = test->positions;
+		uint64_t found = 0;
+		//	one loop per number of checks, so that the ANDs are unrolled
+		switch (test->checks) {
+			case 1:
+				for (int c=0; c<test->numConfigs; c++)
+					found |= checked[positions[c][0]];
+				break;
+			case 2:
+				for (int c=0; c<test->numConfigs; c++)
+					found |= checked[positions[c][0]] & checked[positions[c][1]];
+				break;
+			case 3:
+				for (int c=0; c<test->numConfigs; c++)
+					found |= checked[positions[c][0]] & checked[positions[c][1]] &
+							 checked[positions[c][2]];
+				break;
+			default:
+				for (int c=0; c<test->numConfigs; c++)
+					found |= checked[positions[c][0]] & checked[positions[c][1]] &
+							 checked[positions[c][2]] & checked[positions[c][3]];
+				break;
+		}
+		uint64_t is = countIs(n, test->count) & (test->negate ? ~found : found);
+		if (test->alive)
+			*survive |= is;
+		else
+			*born |= is;
+	}
+}
+
+//	looks for the hash among the last ones (most recent first: smallest period)
+void recordHash(LifeEngine* engine) {
+	unsigned int next = engine->generation % ENGINE_HISTORY_SIZE;
+	if (engine->period == 0) {
+		for (unsigned int k=1; k<=engine->historyLength; k++) {
+			unsigned int slot = (next + ENGINE_HISTORY_SIZE - k) % ENGINE_HISTORY_SIZE;
+			if (engine->history[slot] == engine->hash) {
+				engine->period = (unsigned int) (engine->generation - engine->historyGeneration[slot]);
+				engine->periodFoundAt = engine->generation;
+				break;
+			}
+		}
+	}
+	engine->history[next] = engine->hash;
+	engine->historyGeneration[next] = engine->generation;
+	if (engine->historyLength < ENGINE_HISTORY_SIZE)
+		engine->historyLength++;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int parseRule(const char* text, LifeRule* rule) {
+	if (text[0] >= '1' && text[0] <= '4' && text[1] == '\0') {
+		*rule = BUILT_IN_RULES[text[0] - '1'];
+		return 1;
+	}
+
+	int haveBirth = 0, haveSurvival = 0, haveStates = 0;
+	rule->states = 2;
+	rule->neighborhood = NEIGHBORHOOD_MOORE;
+	memset(rule->transitions, 0, sizeof(rule->transitions));
+	while (*text != '\0') {
+		char letter = toupper(*text++);
+		if ((letter == 'B' && !haveBirth) || (letter == 'S' && !haveSurvival)) {
+			text = parseCounts(text, (letter == 'S') ? CENTER_BIT : 0, rule->transitions);
+			if (text == NULL)
+				return 0;
+			haveBirth |= (letter == 'B');
+			haveSurvival |= (letter == 'S');
+		}
+		else if (letter == 'C' && !haveStates) {
+			char* end;
+			long states = strtol(text, &end, 10);
+			if (end == text || states < 2 || states > MAX_RULE_STATES)
+				return 0;
+			rule->states = (uint8_t) states;
+			text = end;
+			haveStates = 1;
+		}
+		//	the neighborhood letter ends the rule
+		else if ((letter == 'V' || letter == 'H') && *text == '\0')
+			rule->neighborhood = (letter == 'V') ? NEIGHBORHOOD_VON_NEUMANN : NEIGHBORHOOD_HEX;
+		else
+			return 0;
+		if (*text == '/')
+			text++;
+	}
+	summarizeTransitions(rule);
+	//	no more live neighbors than there are neighbors, and letters only
+	//	for the 8 neighbors
+	uint16_t counts = (uint16_t) (2 << NEIGHBORHOOD_SIZE[rule->neighborhood]) - 1;
+	return haveBirth && haveSurvival && !((rule->birth | rule->survival) & ~counts) &&
+		   !(rule->isotropic && rule->neighborhood != NEIGHBORHOOD_MOORE);
+}
+
+void ruleName(LifeRule rule, char* name) {
+	*name++ = 'B';
+	name = writeCounts(&rule, 0, rule.birth, name);
+	*name++ = '/';
+	*name++ = 'S';
+	name = writeCounts(&rule, CENTER_BIT, rule.survival, name);
+	*name = '\0';
+	if (rule.states > 2)
+		name += sprintf(name, "/C%u", rule.states);
+	*name++ = NEIGHBORHOOD_LETTER[rule.neighborhood];
+	*name = '\0';
+}
+
+int ruleTransition(const LifeRule* rule, unsigned int index) {
+	if (rule->isotropic)
+		return inTransitions(rule->transitions, index);
+	uint16_t counts = (index & CENTER_BIT) ? rule->survival : rule->birth;
+	return (counts >> __builtin_popcount(index & NEIGHBOR_BITS)) & 1;
+}
+
+int parseBoundary(const char* text, Boundary* boundary) {
+	for (int k=BOUNDARY_DEAD; k<=BOUNDARY_WRAP; k++) {
+		if (strcmp(text, BOUNDARY_NAME[k]) == 0) {
+			*boundary = (Boundary) k;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+const char* boundaryName(Boundary boundary) {
+	return BOUNDARY_NAME[boundary];
+}
+
+int createEngine(LifeEngine* engine, int maxRows, int maxCols) {
+	memset(engine, 0, sizeof(LifeEngine));
+	engine->maxRows = maxRows;
+	engine->maxCols = maxCols;
+	int maxWords = (maxCols + 63) / 64;
+	size_t size = (size_t) maxRows * MAX_RULE_PLANES * maxWords;
+	engine->cells = (uint64_t*) poolAlloc(size * sizeof(uint64_t));
+	engine->nextCells = (uint64_t*) poolAlloc(size * sizeof(uint64_t));
+	engine->alive = (uint64_t*) poolAlloc((size_t) maxRows * maxWords * sizeof(uint64_t));
+	engine->deadRow = (uint64_t*) poolAlloc(maxWords * sizeof(uint64_t));
+	if (engine->deadRow != NULL)
+		memset(engine->deadRow, 0, maxWords * sizeof(uint64_t));
+	return engine->cells != NULL && engine->nextCells != NULL &&
+		   engine->alive != NULL && engine->deadRow != NULL;
+}
+
+void destroyEngine(LifeEngine* engine) {
+	poolFree(engine->cells);
+	poolFree(engine->nextCells);
+	poolFree(engine->alive);
+	poolFree(engine->deadRow);
+	engine->cells = engine->nextCells = engine->alive = engine->deadRow = NULL;
+}
+
+void startEngine(LifeEngine* engine, int rows, int cols, LifeRule rule,
+				 Boundary boundary, uint64_t seed) {
+	engine->rows = rows;
+	engine->cols = cols;
+	engine->words = (cols + 63) / 64;
+	engine->lastWordMask = (cols & 63) ? (1ull << (cols & 63)) - 1 : ~0ull;
+	engine->rule = rule;
+	compileIsotropicTests(engine);
+	engine->boundary = boundary;
+	engine->numPlanes = 1;
+	while ((1 << engine->numPlanes) < rule.states)
+		engine->numPlanes++;
+
+	//	each word of random bits fills the next 64 cells of the row (alive or
+	//	dead: the dying planes start empty)
+	int words = engine->words;
+	memset(engine->cells, 0, (size_t) rows * engine->numPlanes * words * sizeof(uint64_t));
+	uint64_t state = seed;
+	engine->population = 0;
+	engine->hash = 0;
+	for (int r=0; r<rows; r++) {
+		uint64_t* row = rowPlanes(engine, engine->cells, r);
+		for (int w=0; w<words; w++) {
+			row[w] = nextRandom(&state);
+			if (w == words-1)
+				row[w] &= engine->lastWordMask;
+			engine->population += __builtin_popcountll(row[w]);
+		}
+		engine->hash += rowHash(engine, row, r);
+	}
+
+	engine->generation = 0;
+	engine->births = engine->deaths = 0;
+	engine->historyLength = 0;
+	engine->period = 0;
+	engine->periodFoundAt = 0;
+	recordHash(engine);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Bit-sliced: every operation works on 64 cells.  The neighbors are
+ *	added up into 4 bit planes of counts, the rule becomes masks of the
+ *	cells born & surviving (refined by configuration for non-totalistic rules), and the dying cells' states are incremented as
+ *	binary numbers across the state planes.
+ *---------------------------------------------------------------------------
+ */
+void engineStep(LifeEngine* engine) {
+	int rows = engine->rows, words = engine->words, numPlanes = engine->numPlanes;
+	const LifeRule rule = engine->rule;
+	//	the counts the rule cares about
+	uint16_t counts = rule.birth | rule.survival;
+
+	if (numPlanes > 1) {
+		for (int r=0; r<rows; r++) {
+			const uint64_t* planes = rowPlanes(engine, engine->cells, r);
+			uint64_t* alive = engine->alive + (size_t) r*words;
+			for (int w=0; w<words; w++) {
+				uint64_t higher = 0;
+				for (int p=1; p<numPlanes; p++)
+					higher |= planes[p*words + w];
+				alive[w] = planes[w] & ~higher;
+			}
+		}
+	}
+
+	unsigned long population = 0, births = 0, deaths = 0;
+	uint64_t hash = 0;
+	for (int r=0; r<rows; r++) {
+		const uint64_t* up = aliveRow(engine, r-1);
+		const uint64_t* mid = aliveRow(engine, r);
+		const uint64_t* down = aliveRow(engine, r+1);
+		const uint64_t* planes = rowPlanes(engine, engine->cells, r);
+		uint64_t* next = rowPlanes(engine, engine->nextCells, r);
+
+		for (int w=0; w<words; w++) {
+			uint64_t n[4], nb[8];
+			switch (rule.neighborhood) {
+				case NEIGHBORHOOD_VON_NEUMANN:
+					vonNeumannCounts(engine, up, mid, down, w, n);
+					break;
+				case NEIGHBORHOOD_HEX:
+					hexCounts(engine, up, mid, down, w, r & 1, n);
+					break;
+				default:
+					mooreNeighbors(engine, up, mid, down, w, nb);
+					mooreCounts(nb, n);
+					break;
+			}
+
+			uint64_t born = 0, survive = 0;
+			for (int k=0; k<=8; k++) {
+				if (!(counts & (1 << k)))
+					continue;
+				uint64_t is = countIs(n, k);
+				if (rule.birth & (1 << k))
+					born |= is;
+				if (rule.survival & (1 << k))
+					survive |= is;
+			}
+			if (rule.isotropic)
+				isotropicMasks(engine, nb, n, &born, &survive);
+
+			uint64_t higher = 0;
+			for (int p=1; p<numPlanes; p++)
+				higher |= planes[p*words + w];
+			uint64_t notDead = planes[w] | higher, alive = planes[w] & ~higher;
+			born &= ~notDead;
+			survive &= alive;
+			//	live cells that don't survive, and dying cells, age by one
+			uint64_t ageing = (alive & ~survive) | (notDead & ~alive);
+
+			//	state+1, then back to dead where it reaches the number of states
+			uint64_t carry = ageing, reachesEnd = ageing;
+			uint64_t aged[MAX_RULE_PLANES];
+			for (int p=0; p<numPlanes; p++) {
+				uint64_t bit = planes[p*words + w];
+				aged[p] = bit ^ carry;
+				carry &= bit;
+				reachesEnd &= ((rule.states >> p) & 1) ? aged[p] : ~aged[p];
+			}
+			uint64_t mask = (w == words-1) ? engine->lastWordMask : ~0ull;
+			uint64_t keep = ageing & ~reachesEnd & mask;
+			uint64_t nextNotDead = 0;
+			for (int p=0; p<numPlanes; p++) {
+				uint64_t bit = aged[p] & keep;
+				if (p == 0)
+					bit |= (born | survive) & mask;
+				next[p*words + w] = bit;
+				nextNotDead |= bit;
+			}
+			population += __builtin_popcountll(nextNotDead);
+			births += __builtin_popcountll(born & mask);
+			deaths += __builtin_popcountll(notDead & ~nextNotDead);
+		}
+		hash += rowHash(engine, next, r);
+	}
+
+	uint64_t* temp = engine->cells;
+	engine->cells = engine->nextCells;
+	engine->nextCells = temp;
+	engine->generation++;
+	engine->population = population;
+	engine->births = births;
+	engine->deaths = deaths;
+	engine->hash = hash;
+	recordHash(engine);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Once the grid is in a cycle, running a whole number of periods brings
+ *	it back to the same state: those generations need not be computed.
+ *---------------------------------------------------------------------------
+ */
+void engineRun(LifeEngine* engine, unsigned long generation) {
+	while (engine->generation < generation) {
+		if (engine->period > 0) {
+			unsigned long remaining = generation - engine->generation;
+			engine->generation += remaining - remaining % engine->period;
+			if (engine->generation == generation)
+				break;
+		}
+		engineStep(engine);
+	}
+}
@@ -0,0 +1,153 @@
+//
+//  lifeEngine.h
+//  Cellular Automaton
+//
+//  Small single-threaded engine for batch runs of many independent grids
+//  with any Life-like (B/S) or Generations (B/S/C) rule.  Cells are packed
+//  64 to a word: a cell's state is written in binary across 1 to 4 bit
+//  planes (1 for two-state rules, 2 for Brian's Brain...), so a rule with
+//  more states costs one more bit per cell, not one more byte.  The
+//  neighbors are the 8 around a cell, the 4 orthogonal ones (von Neumann)
+//  or the 6 of a hexagonal lattice, with odd rows shifted half a cell to
+//  the right.  Isotropic non-totalistic rules (Hensel notation: B2-a/S12)
+//  look at which of the 8 neighbors are alive, not only how many.  The
+//  buffers are allocated once for the largest grid, and reused by every run.
+//
+
+#ifndef LIFE_ENGINE_H
+#define LIFE_ENGINE_H
+
+#include <stdint.h>
+
+//	longest period the engine notices
+#define ENGINE_HISTORY_SIZE	256
+//	length of a rule written as text ("B012345678/S012345678/C16", or with
+//	Hensel letters: "B1c2-a3-ai4-ceq5...")
+#define RULE_NAME_LENGTH	96
+//	3x3 neighborhoods, as 9-bit indices: bits 8-6 the row above (west to
+//	east), 5-3 the cell's row (bit 4: the cell itself), 2-0 the row below
+#define NEIGHBORHOOD_INDICES	512
+//	most states of a Generations rule (4 bit planes)
+#define MAX_RULE_STATES		16
+#define MAX_RULE_PLANES		4
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+//	bit n set --> a cell with n live neighbors is born / survives.
+//	With more than 2 states (Generations), a live cell that does not survive
+//	goes through the dying states 2 to states-1, then is dead.  Dying cells
+//	don't count as live neighbors and can't be born again until dead.
+typedef struct LifeRule {
+	uint16_t birth;
+	uint16_t survival;
+	uint8_t states;
+	//	a Neighborhood
+	uint8_t neighborhood;
+	//	1 --> non-totalistic: some counts only give births/survivals for some
+	//	configurations of the live neighbors, and birth & survival only have
+	//	the counts where all configurations do.  Bit k of transitions is then
+	//	whether a cell whose 3x3 neighborhood is k is alive next.
+	uint8_t isotropic;
+	uint64_t transitions[NEIGHBORHOOD_INDICES / 64];
+} LifeRule;
+
+//	written after the rule as in Golly: B2/S34H, B1/S1V (nothing for Moore)
+typedef enum Neighborhood {
+	NEIGHBORHOOD_MOORE = 0,
+	NEIGHBORHOOD_VON_NEUMANN,
+	NEIGHBORHOOD_HEX
+} Neighborhood;
+
+typedef enum Boundary {
+	BOUNDARY_DEAD = 0,
+	BOUNDARY_WRAP
+} Boundary;
+
+//	Configurations of the live neighbors to look for, for a non-totalistic
+//	rule: cells in a state (dead/alive) with count live neighbors, and
+//	whose neighbors are one of the configurations, are alive next (or all
+//	but those, when negate is 1).  A configuration is given by its live
+//	neighbors, or its dead ones when there are fewer (checks of them), as
+//	positions 7-0: NW N NE W E SW S SE.
+typedef struct IsotropicTest {
+	uint8_t alive;
+	uint8_t count;
+	uint8_t negate;
+	uint8_t checks;
+	uint8_t numConfigs;
+	//	at most half of the 70 configurations of 4 live neighbors
+	uint8_t positions[35][4];
+} IsotropicTest;
+
+typedef struct LifeEngine {
+	int maxRows, maxCols;
+	int rows, cols;
+	//	64-bit words per row (in each plane), and the bits of the last word
+	//	that are cells (the others are kept at 0)
+	int words;
+	uint64_t lastWordMask;
+	//	bit planes of the current rule; the planes of a row are next to each
+	//	other: plane p of row r is at cells + (r*numPlanes + p)*words
+	int numPlanes;
+	uint64_t* cells;
+	uint64_t* nextCells;
+	//	which cells are alive (state 1), for rules with more than one plane
+	uint64_t* alive;
+	//	a row of dead cells, above & below the grid when it is not wrapped
+	uint64_t* deadRow;
+	LifeRule rule;
+	//	the non-totalistic counts of the rule, if any
+	IsotropicTest isotropicTests[2*9];
+	int numIsotropicTests;
+	Boundary boundary;
+	unsigned long generation;
+	//	cells that are not dead (dying ones included)
+	unsigned long population;
+	//	changes in the last generation
+	unsigned long births, deaths;
+	//	of which cells are not dead (and of the dying states, if any)
+	uint64_t hash;
+	//	hashes of the last generations, to detect cycles
+	uint64_t history[ENGINE_HISTORY_SIZE];
+	unsigned long historyGeneration[ENGINE_HISTORY_SIZE];
+	unsigned int historyLength;
+	//	first period found (0 --> none) and when
+	unsigned int period;
+	unsigned long periodFoundAt;
+} LifeEngine;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	Parses "B3/S23", "B2/S/C3", "B2/S34H", "B2-a/S12" (any order, case
+//	insensitive but for the Hensel letters) or a built-in rule number 1 to 4;
+//	returns 0 if the text is not a rule
+int parseRule(const char* text, LifeRule* rule);
+//	Writes the rule as "B3/S23", "B2/S/C3", "B2/S34H" or "B2-a/S12" (name must hold RULE_NAME_LENGTH chars)
+void ruleName(LifeRule rule, char* name);
+//	Whether a cell is alive next, from its 3x3 neighborhood (8-neighbor rules)
+int ruleTransition(const LifeRule* rule, unsigned int index);
+int parseBoundary(const char* text, Boundary* boundary);
+const char* boundaryName(Boundary boundary);
+
+//	returns 0 if the buffers could not be allocated
+int createEngine(LifeEngine* engine, int maxRows, int maxCols);
+void destroyEngine(LifeEngine* engine);
+//	Fills the grid at random (half the cells alive) from the seed: the same
+//	seed always gives the same grid.  Allocates nothing.
+void startEngine(LifeEngine* engine, int rows, int cols, LifeRule rule,
+				 Boundary boundary, uint64_t seed);
+//	Computes one generation, updating population, hash history & period
+void engineStep(LifeEngine* engine);
+//	Runs until generation, skipping whole periods once a cycle is found
+void engineRun(LifeEngine* engine, unsigned long generation);
+
+//	64 cells at a time: the number of live neighbors among nb[7] (NW) ...
+//	nb[0] (SE), as 4 bit planes n[3] ... n[0], and which cells have count
+void mooreCounts(const uint64_t* nb, uint64_t* n);
+uint64_t countIs(const uint64_t* n, int count);
+
+#endif // LIFE_ENGINE_H
@@ -0,0 +1,138 @@
+//
+//  loadBalance.c
+//  Cellular Automaton
+//
+//  Threads only write the cost of their own rows, and the slabs are only
+//  recut at the barrier, so no locking here.
+//
+
+#include <stdlib.h>
+#include "loadBalance.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+int balanceRows = 0;
+int balanceSlabs = 0;
+unsigned int balanceInterval = 0;
+
+//	time spent on each row since the last check
+double* windowCost = NULL;
+//	smoothed cost of each row (seconds per generation)
+double* rowCost = NULL;
+//	prefix sums of rowCost: rowCost[0] + ... + rowCost[r-1]
+double* prefixCost = NULL;
+//	recut being considered
+int* candidateBoundaries = NULL;
+
+unsigned int windowGenerations = 0;
+int costKnown = 0;
+unsigned long numRebalances = 0;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+//	cost of the slowest slab
+double slowestSlab(const int* boundaries) {
+	double slowest = 0.0;
+	for (int k=0; k<balanceSlabs; k++) {
+		double cost = prefixCost[boundaries[k+1]] - prefixCost[boundaries[k]];
+		if (cost > slowest)
+			slowest = cost;
+	}
+	return slowest;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Slab k starts at the row where the prefix sum is closest to k shares of
+ *	the total, while leaving at least one row for each of the other slabs.
+ *---------------------------------------------------------------------------
+ */
+void equalCostCut(int* boundaries) {
+	double share = prefixCost[balanceRows] / balanceSlabs;
+	int row = 0;
+	boundaries[0] = 0;
+	for (int k=1; k<balanceSlabs; k++) {
+		double target = k * share;
+		int lowest = boundaries[k-1] + 1;
+		int highest = balanceRows - (balanceSlabs - k);
+		if (row < lowest)
+			row = lowest;
+		while (row < highest && prefixCost[row] < target)
+			row++;
+		//	the row before may be closer to the target
+		if (row > lowest && target - prefixCost[row-1] < prefixCost[row] - target)
+			row--;
+		boundaries[k] = row;
+	}
+	boundaries[balanceSlabs] = balanceRows;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void initializeLoadBalance(int numRows, int numSlabs, unsigned int interval) {
+	balanceRows = numRows;
+	balanceSlabs = numSlabs;
+	balanceInterval = interval;
+	windowCost = (double*) calloc(numRows, sizeof(double));
+	rowCost = (double*) calloc(numRows, sizeof(double));
+	prefixCost = (double*) calloc(numRows+1, sizeof(double));
+	candidateBoundaries = (int*) calloc(numSlabs+1, sizeof(int));
+}
+
+void recordSlabCost(int startRow, int endRow, double seconds) {
+	if (windowCost == NULL || endRow <= startRow)
+		return;
+	double perRow = seconds / (endRow - startRow);
+	for (int r=startRow; r<endRow; r++)
+		windowCost[r] += perRow;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	The cost of a row is only known as an average over the slab it was in,
+ *	so the estimate sharpens as the boundaries move.  Averaging windows
+ *	and the two hysteresis tests keep the slabs from flapping back and
+ *	forth on timing noise.
+ *---------------------------------------------------------------------------
+ */
+int rebalanceSlabs(int* boundaries) {
+	if (windowCost == NULL || balanceInterval == 0 || balanceSlabs < 2)
+		return 0;
+	if (++windowGenerations < balanceInterval)
+		return 0;
+
+	prefixCost[0] = 0.0;
+	for (int r=0; r<balanceRows; r++) {
+		double cost = windowCost[r] / windowGenerations;
+		rowCost[r] = costKnown ? 0.5*(rowCost[r] + cost) : cost;
+		prefixCost[r+1] = prefixCost[r] + rowCost[r];
+		windowCost[r] = 0.0;
+	}
+	windowGenerations = 0;
+	costKnown = 1;
+
+	double total = prefixCost[balanceRows];
+	if (total <= 0.0)
+		return 0;
+	double slowest = slowestSlab(boundaries);
+	if (slowest < REBALANCE_THRESHOLD * total / balanceSlabs)
+		return 0;
+
+	equalCostCut(candidateBoundaries);
+	if (slowestSlab(candidateBoundaries) >= (1.0 - REBALANCE_MIN_GAIN) * slowest)
+		return 0;
+	for (int k=0; k<=balanceSlabs; k++)
+		boundaries[k] = candidateBoundaries[k];
+	numRebalances++;
+	return 1;
+}
+
+unsigned long rebalanceCount(void) {
+	return numRebalances;
+}
@@ -0,0 +1,35 @@
+//
+//  loadBalance.h
+//  Cellular Automaton
+//
+//  Moves the boundaries between the threads' slabs of rows so that every
+//  thread gets about the same amount of work.  Each thread reports the time
+//  it spent on its rows; that time is spread over the rows to estimate the
+//  cost of each row, and every few generations the slabs are recut at equal
+//  shares of the cumulated (prefix sum) cost.
+//
+
+#ifndef LOAD_BALANCE_H
+#define LOAD_BALANCE_H
+
+//	generations between two rebalancing checks, by default
+#define REBALANCE_INTERVAL	16
+//	hysteresis: only recut when the slowest slab is that much above average...
+#define REBALANCE_THRESHOLD	1.10
+//	...and when the recut makes the slowest slab at least that much faster
+#define REBALANCE_MIN_GAIN	0.05
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void initializeLoadBalance(int numRows, int numSlabs, unsigned int interval);
+//	Called by each thread for its own rows [startRow, endRow) once per generation
+void recordSlabCost(int startRow, int endRow, double seconds);
+//	Called once per generation while no thread is computing.  boundaries holds
+//	numSlabs+1 row indices (slab k is [boundaries[k], boundaries[k+1])); returns
+//	1 if they were changed
+int rebalanceSlabs(int* boundaries);
+unsigned long rebalanceCount(void);
+
+#endif // LOAD_BALANCE_H
@@ -25,9 +25,22 @@
  |        - 'c' --> toggle color mode on/off                                                |
  |        - 'b' --> toggles color mode off/on                                               |
  |        - 'l' --> toggles on/off grid line rendering                                      |
+ |        - 'w' --> toggles on/off wrapping around the edges (torus)                        |
  |                                                                                          |
- |        - '+' --> increase simulation speed                                               |
+ |        - '+' --> increase simulation speed (target generations/sec)                      |
  |        - '-' --> reduce simulation speed                                                 |    
+ |        - 'u' --> toggle unlimited speed                                                  |
+ |        - 'f' --> fast-forward 1000 generations (again to cancel)                         |
+ |                                                                                          |
+ |        - '[' --> smaller brush for painting cells with the mouse                         |
+ |        - ']' --> larger brush                                                            |
+ |        - 'p' --> next pattern stamped by a left click (or back to painting)              |
+ |                                                                                          |
+ |        - 'z' --> zoom in around the middle of the grid pane                              |
+ |        - 'x' --> zoom out around the middle of the grid pane                             |
+ |        - 'h' --> back to the whole grid                                                  |
+ |        - arrow keys --> pan by an eighth of the pane                                     |
+ |        - 'o' --> with -plane, the window follows the live cells (again to stop)          |
  |                                                                                          |
  |        - '1' --> apply Rule 1 (Conway's classical Game of Life: B3/S23)                  |
  |        - '2' --> apply Rule 2 (Coral: B3/S45678)                                         |
@@ -35,27 +48,70 @@
  |        - '4' --> apply Rule 4 (Maze: B3/S12345)                                          |
  |                                                                                          |
  |  * String to compile the program by linking GLUT & pthread:                              |              
- |      - gcc main.c gl_frontEnd.c -lm -lpthread -framework OpenGL -framework GLUT -o cell  |                                                           |
+ |      - gcc *.c -lm -lpthread -framework OpenGL -framework GLUT -o cell                    |                                                           |
  +------------------------------------------------------------------------------------------*/
 
 #include <stdio.h>          // for printf
 #include <stdlib.h>         // for exit
+#include <string.h>         // for strcmp
 #include <unistd.h>         // for stderror
 #include <time.h>           // for usleep()
 #include <pthread.h>        // for pthread_* calls
-#include <semaphore.h>      // for semaphores
 #include <sys/stat.h>       // for pipes
+#include <fcntl.h>          // for open
+#include <poll.h>           // for poll
+#include <errno.h>          // for errno
 #include "gl_frontEnd.h"
+#include "frameExport.h"
+#include "commandQueue.h"
+#include "controlSocket.h"
+#include "perfCounters.h"
+#include "traceEvents.h"
+#include "genStats.h"
+#include "cycleDetect.h"
+#include "loadBalance.h"
+#include "wavefront.h"
+#include "processLauncher.h"
+#include "ensemble.h"
+#include "survey.h"
+#include "lifeEngine.h"
+#include "largerThanLife.h"
+#include "blockTable.h"
+#include "gridLayout.h"
+#include "sparsePlane.h"
+#include "poolAlloc.h"
+#include "cellEdits.h"
 
 //==================================================================================
 //    Thread data type
 //==================================================================================
 
+// liveness of a row, hashed 64 cells at a time; on a tiled grid a row is
+// computed one band at a time, and its hash goes on from band to band
+typedef struct RowHash {
+    uint64_t hash;
+    uint64_t aliveBits;
+    // with dying states, the bits of the states
+    uint64_t stateBits[MAX_RULE_PLANES];
+} RowHash;
+
 typedef struct ThreadInfo {
     pthread_t threadID;
     int index;
     int startIndex;
     int endIndex;
+    // time (in seconds) spent computing its rows in the last generation
+    double computeTime;
+    // population counts of its rows in the generation being computed
+    // (own cache line: written for every cell)
+    // (one per buffer of the wavefront ring; the barrier only uses the first)
+    _Alignas(CACHE_LINE_SIZE) GenerationStats stats[WAVEFRONT_MAX_RING];
+    // neighbor counts of its rows, with a Larger than Life rule
+    BoxSums boxSums;
+    // next states of the two rows being computed with the block table
+    unsigned char* blockStates;
+    // hashes of the rows of its slab, on a tiled grid (numRows of them)
+    RowHash* rowHashes;
 } ThreadInfo;
 
 //==================================================================================
@@ -65,17 +121,44 @@ typedef struct ThreadInfo {
 void displayGridPane(void);
 void displayStatePane(void);
 void initializeApplication(void);
+void createWorkerThreads(void);
 void* threadFunc(void* arg);
+void* wavefrontThreadFunc(void* arg);
 void swapGrids(void);
-void rowGeneration(int row);
+void rowGeneration(int** grid, int** next, int row, int firstCol, int endCol, const int* counts,
+                   const unsigned char* newStates, GenerationStats* stats, RowHash* rowHash);
+uint64_t slabGeneration(ThreadInfo* info, const Grid* grid, const Grid* next, GenerationStats* stats);
 void* threadFunction(void* arg);
 void* namedPipeServer(void*);
+int applyPendingCommands(void);
+int inputPending(void);
+void parseOptions(int argc, char** argv);
+void completeGeneration(int statsSlot);
+void completeWavefrontGeneration(unsigned long gen);
+void applyWavefrontCommands(void);
+void initializeWavefrontRing(void);
+void exchangeHalos(void);
+Grid* allocateGrid(void);
+void setHaloRows(Grid* grid);
+uint64_t paceGeneration(void);
+void rebalanceThreads(void);
+void handleCycle(unsigned int period, unsigned long population);
+void shutdownApplication(void);
+double currentTime(void);
 
-unsigned int cellNewState(unsigned int i, unsigned int j);
-// control the access of all threads to a resource (swapping grids in this case)
+unsigned int cellNewState(int** grid, int i, int j);
+unsigned int customNewState(int** grid, int i, int j);
+unsigned int ltlNewState(int state, int count);
+unsigned int ruleStates(void);
+int ltlRuleFits(const LtlRule* newRule);
+LifeRule currentLifeRule(void);
+void updateBlockTable(void);
+void finishPlaneGeneration(void);
+void centerPlaneWindow(void);
+// protects the count of threads that are done with the current generation
 pthread_mutex_t myLock;
-// prevent dobule execution of threads in a row
-sem_t mutex;
+// signaled when the last thread has completed the generation
+pthread_cond_t generationDone;
 
 //==================================================================================
 //    Precompiler #define to let us specify how things should be handled at the
@@ -89,6 +172,7 @@ sem_t mutex;
 #define FRAME_WRAP          3    //    same rule as elsewhere, with wrapping around at edges
 
 // Pick one value for FRAME_BEHAVIOR
+// (wrapping can also be turned on & off at run time: -boundary, "wrap" command)
 #define FRAME_BEHAVIOR    FRAME_DEAD
 
 //==================================================================================
@@ -103,18 +187,59 @@ extern int gMainWindow, gSubwindow[2];
 //        - currentGrid is the one displayed in the graphic front end
 //        - nextGrid is the grid that stores the next generation of cell
 //            states, as computed by our threads.
-int* currentGrid;
-int* nextGrid;
-int** currentGrid2D;
-int** nextGrid2D;
+//    Both have a halo: one more row & column on each side, so rows -1
+//    to numRows and columns -1 to numCols are valid (see gridLayout.h).
+Grid* currentGrid;
+Grid* nextGrid;
+// rows --> one row after the other; tiled --> bands of tileCols columns
+GridLayout gridLayout = LAYOUT_ROWS;
+int tileCols = DEFAULT_TILE_COLS;
+
+// -plane: the cells live in an unbounded plane, and currentGrid is only the
+// window onto it that gets drawn, top-left cell at (viewRow, viewCol).
+// The window stays where the user pans it (-follow, "follow on": it keeps
+// the middle of the live cells in its middle instead)
+int planeMode = 0;
+SparsePlane plane;
+long viewRow = 0;
+long viewCol = 0;
+int followLiveCells = 0;
 
 int numRows;
 int numCols;
 int maxNumThreads;
 int numThreads;
 
+// the grid is a torus: the halo rows are the last & first rows themselves
+// and each row's halo cells are copies of its last & first cells
+int wrapFrame = (FRAME_BEHAVIOR == FRAME_WRAP);
+
+// size of the whole grid and index in it of our row 0 (when the grid is
+// split between processes, the halo rows hold the neighbors' edge rows)
+int globalNumRows;
+int globalRowOffset = 0;
+// processes sharing the grid, and which band of rows we own (-1 --> alone)
+int numProcesses = 1;
+int processRank = -1;
+const HaloTransport* haloTransport = NULL;
+unsigned int randomSeed;
+
 int swapCounter;
-int applicationSpeed = 100;
+// incremented each time the threads get released into a new generation
+unsigned long barrierPhase = 0;
+
+// pace of the simulation, in generations per second (0 --> unlimited)
+double targetRate = 60.0;
+// deadline for the end of the next generation (CLOCK_MONOTONIC)
+struct timespec nextDeadline = {0, 0};
+// how long the last generation slept to keep the pace
+uint64_t pacingSleepNs = 0;
+// 0 --> threads meet at a barrier after each generation, else number of grids
+// in the ring used when slabs synchronize with their neighbors only
+unsigned int wavefrontRingSize = 0;
+Grid* wavefrontRing[WAVEFRONT_MAX_RING];
+// generations between two checks of the threads' share of work (0 --> fixed slabs)
+unsigned int rebalanceInterval = REBALANCE_INTERVAL;
 
 int fd1;
 // able to hold the size of all command strings
@@ -128,9 +253,57 @@ unsigned int numLiveThreads = 0;
 // arrays of numbers.  So, in this program I hard-code my rules
 
 unsigned int rule = GAME_OF_LIFE_RULE;
+// ... except for CUSTOM_RULE, which can be any B/S rule, or a multi-state
+// (Generations) B/S/C one, where the states past 1 are dying cells,
+// and LARGER_THAN_LIFE_RULE, which counts the neighbors in a larger box
+LifeRule customRule = {.birth = 1<<3, .survival = (1<<2) | (1<<3), .states = 2,
+                       .neighborhood = NEIGHBORHOOD_MOORE};
+LtlRule largerRule = {5, 2, 1, 34, 45, 34, 58};
+//	(long enough for Larger than Life rules too)
+char customRuleName[RULE_NAME_LENGTH] = "B3/S23";
+// next 2x2 center cells of each 4x4 block under the current rule, used when
+// the rule has two states & 8 neighbors (unless -engine cell)
+uint8_t blockTable[BLOCK_TABLE_SIZE];
+int blockTableAllowed = 1;
+int blockTableReady = 0;
 
 unsigned int colorMode = 0;
 
+// number of generations computed since launch
+unsigned long generation = 0;
+// stop the application after that many generations (0 --> run forever)
+unsigned long maxGenerations = 0;
+// run without the glut window (for frame export & batch runs)
+int headless = 0;
+// percentage of live cells in a random grid
+int initialDensity = 50;
+
+// generations per second, measured over roughly half a second
+double generationRate = 0.0;
+double rateStartTime = 0.0;
+unsigned long rateStartGeneration = 0;
+
+// the worker threads, so that their timings can be reported
+ThreadInfo* threads;
+
+const char* RULE_NAME[] = {"", "Game of Life B3/S23", "Coral B3/S45678",
+                           "Amoeba B357/S1358", "Maze B3/S12345"};
+
+// what to do when the grid falls into a cycle (see cycleDetect.h)
+CycleAction cycleAction = CYCLE_LOG;
+// set while the workers are parked on a cycle
+int workersParked = 0;
+
+// "ff N" / "step N": generations left to run at full speed, without
+// sleeping or rendering, and the size of the whole request
+unsigned long fastForwardRemaining = 0;
+unsigned long fastForwardTotal = 0;
+
+// where to write the Chrome trace (NULL --> no tracing)
+const char* tracePath = NULL;
+
+ExportSettings exportOptions = {0, ".", EXPORT_PNG, 1, 2, 0, 0};
+
 //==================================================================================
 //    These are the functions that tie the simulation with the rendering.
 //    Some parts are "don't touch."  Other parts need your intervention
@@ -138,6 +311,10 @@ unsigned int colorMode = 0;
 //==================================================================================
 
 void displayGridPane(void) {
+    // while fast-forwarding, leave the last frame on screen
+    if(fastForwardRemaining > 0)
+        return;
+
     //    This is OpenGL/glut magic.  Don't touch
     glutSetWindow(gSubwindow[GRID_PANE]);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -148,7 +325,10 @@ void displayGridPane(void) {
     //    This is the call that makes OpenGL render the grid.
     //
     //---------------------------------------------------------
-    drawGrid(currentGrid2D, numRows, numCols);
+    traceRegisterThread("glut");
+    traceBegin(TRACE_RENDER);
+    drawGrid(currentGrid, numRows, numCols);
+    traceEnd(TRACE_RENDER);
     
     //    This is OpenGL/glut magic.  Don't touch
     glutSwapBuffers();
@@ -168,7 +348,17 @@ void displayStatePane(void) {
     //    about the state of the simulation.
     //
     //---------------------------------------------------------
-    drawState(numLiveThreads);
+    // refresh the rates twice a second so that they are readable
+    static PerfSummary perf;
+    static double lastSampleTime = 0.0;
+    if(currentTime() - lastSampleTime >= 0.5) {
+        samplePerformance(&perf, generation);
+        lastSampleTime = currentTime();
+    }
+    GenerationStats stats;
+    readStats(&stats);
+    perf.targetGensPerSec = targetRate;
+    drawState(numLiveThreads, &perf, &stats);
     
     //    This is OpenGL/glut magic.  Don't touch
     glutSwapBuffers();
@@ -179,34 +369,307 @@ void displayStatePane(void) {
 /*
  *------------------------------------------------------------------------
  * Unique thread created the named pipe and handles communication between
+ *........................................................................
+ * The pipe is opened once, read/write & non-blocking: since we hold a
+ *  writer ourselves, read() never reports end-of-file when a script's
+ *  echo closes its end, and nothing written in between opens is lost.
+ *  A single read may bring several newline-terminated commands, which
+ *  are queued for the worker threads to apply between generations.
  *------------------------------------------------------------------------
  */
 void* namedPipeServer(void* arg) {
-    FILE *fptr;
     char path[] = "/tmp/namedPipe";
-    char readbuf[80];
+    char readbuf[4096];
+    // a command may be split across two reads
+    char line[COMMAND_LENGTH];
+    int lineLength = 0;
 
     umask(0);
     mknod(path, S_IFIFO|0666, 0);
 
+    int fd = open(path, O_RDWR | O_NONBLOCK);
+    if(fd < 0) {
+        printf("could not open %s\n", path);
+        return NULL;
+    }
+    struct pollfd pipePoll = {fd, POLLIN, 0};
+
     // thread running... listening for commands
     while(1) {
-        fptr = fopen(path, "r");
-        fgets(readbuf, 80, fptr);
-        pipeToCommand(readbuf);
-        fclose(fptr);
+        if(poll(&pipePoll, 1, -1) < 0) {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+        ssize_t numRead = read(fd, readbuf, sizeof(readbuf));
+        if(numRead <= 0)
+            continue;
+
+        for(ssize_t k = 0; k < numRead; k++) {
+            if(readbuf[k] != '\n') {
+                // overly long commands are truncated (they are invalid anyway)
+                if(lineLength < COMMAND_LENGTH-1)
+                    line[lineLength++] = readbuf[k];
+                continue;
+            }
+            line[lineLength] = '\0';
+            if(lineLength > 0) {
+                // the queue only fills up if the simulation is stalled:
+                // wait for it rather than lose a command
+                while(!pushCommand(line))
+                    usleep(1000);
+            }
+            lineLength = 0;
+        }
     }
+    close(fd);
     return NULL;
 }
 
+/*
+ *------------------------------------------------------------------------
+ * One cell of a mouse edit, in the grid (or the window onto the plane)
+ *------------------------------------------------------------------------
+ */
+void setEditedCell(int row, int col, int state) {
+    // (a process only has a share of the rows, and no window: the front
+    // end refuses to queue edits with -processes)
+    if(processRank >= 0) {
+        return;
+    }
+    if(planeMode) {
+        setPlaneCell(&plane, viewRow + row, viewCol + col, state);
+    } else if(row >= 0 && row < numRows && col >= 0 && col < numCols) {
+        *gridCell(currentGrid, row, col) = state;
+    }
+}
+
+/*
+ *------------------------------------------------------------------------
+ * 1 if a command or a mouse edit is waiting to be applied (only called
+ *  by the thread completing a generation, which takes the edits out)
+ *------------------------------------------------------------------------
+ */
+int inputPending(void) {
+    return commandPending() || editPending();
+}
+
+/*
+ *------------------------------------------------------------------------
+ * Applies the commands received since the last generation, then the
+ *  mouse edits (which the commands may have added to)
+ *------------------------------------------------------------------------
+ */
+int applyPendingCommands(void) {
+    char pendingCommand[COMMAND_LENGTH];
+    int numApplied = 0;
+    while(popCommand(pendingCommand)) {
+        pipeToCommand(pendingCommand);
+        // moving the plane's window changes no cell: it doesn't get the
+        // workers out of a park, nor restart the cycle search
+        if(strncmp(pendingCommand, "view ", 5) != 0 && strncmp(pendingCommand, "follow ", 7) != 0)
+            numApplied++;
+    }
+    int numEdits = applyCellEdits(setEditedCell);
+    if(numEdits > 0) {
+        // the halos (or the plane's chunks & window) must follow the cells
+        if(planeMode) {
+            tidyPlane(&plane);
+            copyPlaneWindow(&plane, viewRow, viewCol, currentGrid);
+        } else {
+            refreshGridEdges(currentGrid, wrapFrame);
+        }
+        numApplied += numEdits;
+    }
+    // a new rule, a reset... may get us out of the cycle we were in
+    if(numApplied > 0)
+        clearCycleHistory();
+    return numApplied;
+}
+
+/*
+ *------------------------------------------------------------------------
+ * Reads the optional flags that follow rows, columns & threads
+ *------------------------------------------------------------------------
+ */
+void parseOptions(int argc, char** argv) {
+    int rateGiven = 0;
+    int seedGiven = 0;
+    const char* transportName = "shm";
+    for(int i = 0; i < argc; i++) {
+        // every option but -headless, -rawstdout, -plane & -follow takes a value
+        int hasValue = (i+1 < argc);
+        if(strcmp(argv[i], "-headless") == 0) {
+            headless = 1;
+        } else if(strcmp(argv[i], "-plane") == 0) {
+            planeMode = 1;
+        } else if(strcmp(argv[i], "-follow") == 0) {
+            followLiveCells = 1;
+        } else if(strcmp(argv[i], "-rawstdout") == 0) {
+            exportOptions.rawStdout = 1;
+            exportOptions.noFiles = 1;
+        } else if(strcmp(argv[i], "-gens") == 0 && hasValue) {
+            sscanf(argv[++i], "%lu", &maxGenerations);
+        } else if(strcmp(argv[i], "-export") == 0 && hasValue) {
+            sscanf(argv[++i], "%u", &exportOptions.interval);
+        } else if(strcmp(argv[i], "-outdir") == 0 && hasValue) {
+            exportOptions.directory = argv[++i];
+            exportOptions.noFiles = 0;
+        } else if(strcmp(argv[i], "-format") == 0 && hasValue) {
+            i++;
+            if(strcmp(argv[i], "png") != 0 && strcmp(argv[i], "ppm") != 0) {
+                printf("-format must be png or ppm\n");
+                exit(-1);
+            }
+            exportOptions.format = (strcmp(argv[i], "ppm") == 0) ? EXPORT_PPM : EXPORT_PNG;
+        } else if(strcmp(argv[i], "-scale") == 0 && hasValue) {
+            sscanf(argv[++i], "%u", &exportOptions.scale);
+        } else if(strcmp(argv[i], "-encoders") == 0 && hasValue) {
+            sscanf(argv[++i], "%u", &exportOptions.numEncoders);
+        } else if(strcmp(argv[i], "-trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if(strcmp(argv[i], "-rate") == 0 && hasValue) {
+            sscanf(argv[++i], "%lf", &targetRate);
+            rateGiven = 1;
+        } else if(strcmp(argv[i], "-rebalance") == 0 && hasValue) {
+            sscanf(argv[++i], "%u", &rebalanceInterval);
+        } else if(strcmp(argv[i], "-wavefront") == 0 && hasValue) {
+            unsigned int lead = 0;
+            sscanf(argv[++i], "%u", &lead);
+            if(lead < 1 || lead >= WAVEFRONT_MAX_RING) {
+                printf("-wavefront takes a lead of 1 to %d generations\n", WAVEFRONT_MAX_RING-1);
+                exit(-1);
+            }
+            wavefrontRingSize = lead + 1;
+        } else if(strcmp(argv[i], "-processes") == 0 && hasValue) {
+            sscanf(argv[++i], "%d", &numProcesses);
+        } else if(strcmp(argv[i], "-transport") == 0 && hasValue) {
+            transportName = argv[++i];
+        } else if(strcmp(argv[i], "-seed") == 0 && hasValue) {
+            sscanf(argv[++i], "%u", &randomSeed);
+            seedGiven = 1;
+        } else if(strcmp(argv[i], "-rule") == 0 && hasValue) {
+            if(!setCustomRule(argv[++i])) {
+                printf("-rule must be 1 - 4, B.../S..., B.../S.../C... (at most %d states)\n"
+                       "or R.,C.,M.,S..,B..,NM (radius at most %d and below half the grid size,\n"
+                       "without -processes; with -wavefront, slabs at least as tall as the radius);\n"
+                       "with -plane, only two-state B/S rules on the 8 neighbors, without B0 or Hensel letters\n",
+                       MAX_CELL_STATES, LTL_MAX_RADIUS);
+                exit(-1);
+            }
+        } else if(strcmp(argv[i], "-engine") == 0 && hasValue) {
+            i++;
+            if(strcmp(argv[i], "cell") != 0 && strcmp(argv[i], "block") != 0) {
+                printf("-engine must be cell or block\n");
+                exit(-1);
+            }
+            blockTableAllowed = (strcmp(argv[i], "block") == 0);
+        } else if(strcmp(argv[i], "-layout") == 0 && hasValue) {
+            if(!parseGridLayout(argv[++i], &gridLayout)) {
+                printf("-layout must be rows or tiled\n");
+                exit(-1);
+            }
+        } else if(strcmp(argv[i], "-tilecols") == 0 && hasValue) {
+            sscanf(argv[++i], "%d", &tileCols);
+            if(tileCols < MIN_TILE_COLS) {
+                printf("-tilecols must be at least %d\n", MIN_TILE_COLS);
+                exit(-1);
+            }
+        } else if(strcmp(argv[i], "-density") == 0 && hasValue) {
+            sscanf(argv[++i], "%d", &initialDensity);
+            if(initialDensity < 0 || initialDensity > 100) {
+                printf("-density must be 0 - 100 (percent)\n");
+                exit(-1);
+            }
+        } else if(strcmp(argv[i], "-boundary") == 0 && hasValue) {
+            Boundary boundary;
+            if(!parseBoundary(argv[++i], &boundary)) {
+                printf("-boundary must be dead or wrap\n");
+                exit(-1);
+            }
+            wrapFrame = (boundary == BOUNDARY_WRAP);
+        } else if(strcmp(argv[i], "-oncycle") == 0 && hasValue) {
+            if(!parseCycleAction(argv[++i], &cycleAction)) {
+                printf("-oncycle must be log, stop, park or reset\n");
+                exit(-1);
+            }
+        } else if(strcmp(argv[i], "-csv") == 0 && hasValue) {
+            if(!openStatsCSV(argv[++i])) {
+                printf("could not create %s\n", argv[i]);
+                exit(-1);
+            }
+        } else {
+            printf("Unknown option %s\n", argv[i]);
+            exit(-1);
+        }
+    }
+
+    // every process must draw the same initial grid
+    if(!seedGiven) {
+        randomSeed = (unsigned int) time(NULL);
+    }
+
+    // the processes only compute: no window, no files, and commands or
+    // cycles can't be handled by one band of rows alone
+    if(numProcesses > 1) {
+        haloTransport = findTransport(transportName);
+        if(haloTransport == NULL) {
+            printf("Unknown transport %s\n", transportName);
+            exit(-1);
+        }
+        if(!headless || wavefrontRingSize > 0 || exportOptions.interval > 0 ||
+           tracePath != NULL || cycleAction != CYCLE_LOG || numProcesses*2 > numRows) {
+            printf("-processes requires -headless, at least 2 rows per process, "
+                   "and no -wavefront, -export, -trace or -oncycle\n");
+            exit(-1);
+        }
+        closeStatsCSV();
+        rebalanceInterval = 0;
+    }
+
+    // slab boundaries can't move while slabs are at different generations
+    if(wavefrontRingSize > 0) {
+        rebalanceInterval = 0;
+    }
+
+    // the threads share the plane's chunks, not rows, and there is no edge
+    if(planeMode) {
+        if(wavefrontRingSize > 0 || numProcesses > 1) {
+            printf("%s\n", "-plane can't be used with -wavefront or -processes");
+            exit(-1);
+        }
+        rebalanceInterval = 0;
+        wrapFrame = 0;
+    }
+
+    // nobody is watching a headless run: go as fast as possible
+    if(headless && !rateGiven) {
+        targetRate = 0.0;
+    }
+
+    // a headless run that never stops would be hard to get rid of
+    if(headless && maxGenerations == 0) {
+        printf("%s\n", "-headless requires -gens");
+        exit(-1);
+    }
+}
+
 /*
  *------------------------------------------------------------------------
  *   Main function where the threads are created
  *------------------------------------------------------------------------
  */
 int main(int argc, char** argv) {
+    // batch of independent grids: nothing else of the application is needed
+    if(argc > 1 && strcmp(argv[1], "-ensemble") == 0) {
+        return runEnsemble(argc-2, argv+2);
+    }
+    if(argc > 1 && strcmp(argv[1], "-survey") == 0) {
+        return runSurvey(argc-2, argv+2);
+    }
+
     // check if we have the correct parameters
-    if(argc != 4) {
+    if(argc < 4) {
         printf("%s\n", "Wrong Number of Arguments");
         exit(-1);
     }
@@ -220,27 +683,104 @@ int main(int argc, char** argv) {
         printf("%s\n", "Incorrect Values as Dimensions or Threads");
         exit(-1);
     }
+    globalNumRows = numRows;
+    // everything after the dimensions & threads is optional
+    parseOptions(argc-4, argv+4);
+    // (the options after -rule may not suit it)
+    if(rule == LARGER_THAN_LIFE_RULE && !ltlRuleFits(&largerRule)) {
+        printf("%s does not fit this grid, -processes or -wavefront\n", customRuleName);
+        exit(-1);
+    }
+    updateBlockTable();
+    if(planeMode) {
+        LifeRule lifeRule = currentLifeRule();
+        if(rule == LARGER_THAN_LIFE_RULE || !planeRuleFits(&lifeRule)) {
+            printf("-plane requires a two-state B/S rule on the 8 neighbors, without B0 or Hensel letters\n");
+            exit(-1);
+        }
+        createPlane(&plane, lifeRule);
+    }
+
+    if(numProcesses > 1) {
+        // only the processes come back from here (rows are exchanged halo included)
+        processRank = launchProcesses(numProcesses, haloTransport, numCols+2, wrapFrame);
+        int startRow, endRow;
+        rankRows(processRank, numProcesses, globalNumRows, &startRow, &endRow);
+        numRows = endRow - startRow;
+        globalRowOffset = startRow;
+    }
+    initializeTracing(tracePath);
 
     // creating a thread for the named pipe to read constantly
+    // (the processes sharing a grid don't take commands)
+    initializeCommandQueue();
+    initializeEditQueue();
     pthread_t namedpipeID;
-    int pipeCode = pthread_create(&namedpipeID, NULL, namedPipeServer, NULL);
+    int pipeCode = processRank < 0 ? pthread_create(&namedpipeID, NULL, namedPipeServer, NULL) : 0;
     // exit if we could not make a pipe
     if( pipeCode != 0) {
         // printf ("could not create thread for pipe.\n");
         exit(0);
     }
+    // the control socket answers queries & accepts the same commands
+    pthread_t controlSocketID;
+    if(processRank < 0 && pthread_create(&controlSocketID, NULL, controlSocketServer, NULL) != 0) {
+        printf("could not create thread for control socket.\n");
+        exit(0);
+    }
 
     // This takes care of initializing glut and the GUI.
     // You shouldn’t have to touch this
-    initializeFrontEnd(argc, argv, displayGridPane, displayStatePane);
+    if(!headless) {
+        initializeFrontEnd(argc, argv, displayGridPane, displayStatePane);
+    }
 
     // Now we can do application-level initialization
     initializeApplication();
+    exchangeHalos();
+    initializeExport(&exportOptions, numRows, numCols);
+    // flush the frames still being encoded however we exit
+    atexit(shutdownApplication);
     
-    // initialize the mutex lock & semaphore to prevent race condition
+    // initialize the mutex lock & condition used as a generation barrier
     pthread_mutex_init(&myLock, NULL);
-    sem_init(&mutex, 0, 1);
+    pthread_cond_init(&generationDone, NULL);
     
+    createWorkerThreads();
+
+    // without a window, the main thread just waits for the workers
+    // (the application exits once maxGenerations is reached)
+    if(headless) {
+        for(int i = 0; i < numThreads; i++) {
+            pthread_join(threads[i].threadID, NULL);
+        }
+    }
+
+    //    Now we enter the main loop of the program and to a large extend
+    //    "lose control" over its execution.  The callback functions that
+    //    we set up earlier will be called when the corresponding event
+    //    occurs
+    glutMainLoop();
+    //    In fact this code is never reached because we only leave the glut main
+    //    loop through an exit call.
+    //    Free allocated resource before leaving (not absolutely needed, but
+    //    just nicer.  Also, if you crash there, you know something is wrong
+    //    in your code.
+    pthread_cond_destroy(&generationDone);
+    destroyGrid(currentGrid);
+    destroyGrid(nextGrid);
+    //    This will never be executed (the exit point will be in one of the
+    //    call back functions).
+    return 0;
+}
+
+/*
+ *------------------------------------------------------------------------
+ * Splits the rows between the worker threads and starts them (after
+ *  the grids, queues & barrier are set up)
+ *------------------------------------------------------------------------
+ */
+void createWorkerThreads(void) {
     // figure out how many threads we need to create
     if(maxNumThreads > numRows) {
         numThreads = numRows;
@@ -249,7 +789,13 @@ int main(int argc, char** argv) {
     }
 
     // array for all the threads to easily access
-    ThreadInfo threads[numThreads];
+    threads = (ThreadInfo*) aligned_alloc(CACHE_LINE_SIZE, numThreads*sizeof(ThreadInfo));
+    memset(threads, 0, numThreads*sizeof(ThreadInfo));
+    initializePerfCounters(numThreads);
+    initializeLoadBalance(numRows, numThreads, rebalanceInterval);
+    if(wavefrontRingSize > 0) {
+        initializeWavefrontRing();
+    }
     int errCode;
     int startIndex = -1;
     // keeps track of the total amount of rows the threads have to allocate
@@ -271,30 +817,14 @@ int main(int argc, char** argv) {
 
         numLiveThreads++;
         errCode = pthread_create(&threads[i].threadID, NULL,
-                                  threadFunc, threads + i);
+                                  wavefrontRingSize > 0 ? wavefrontThreadFunc : threadFunc,
+                                  threads + i);
         // stop if we could not create a thread
         if (errCode != 0) {
             printf("Could nopt create thread\n");
             exit (EXIT_FAILURE);
         }
     }
-    
-    //    Now we enter the main loop of the program and to a large extend
-    //    "lose control" over its execution.  The callback functions that
-    //    we set up earlier will be called when the corresponding event
-    //    occurs
-    glutMainLoop();
-    //    In fact this code is never reached because we only leave the glut main
-    //    loop through an exit call.
-    //    Free allocated resource before leaving (not absolutely needed, but
-    //    just nicer.  Also, if you crash there, you know something is wrong
-    //    in your code.
-    sem_destroy(&mutex);
-    free(currentGrid2D);
-    free(currentGrid);
-    //    This will never be executed (the exit point will be in one of the
-    //    call back functions).
-    return 0;
 }
 
 /*
@@ -303,51 +833,236 @@ int main(int argc, char** argv) {
  *------------------------------------------------------------------------
  */
 void initializeApplication(void) {
-    //  Allocate 1D grids
-    //--------------------
-    currentGrid = (int*) malloc(numRows*numCols*sizeof(int));
-    nextGrid = (int*) malloc(numRows*numCols*sizeof(int));
+    //  Allocate the grids (with their halo) & their row scaffolds
+    //--------------------------------------------------------------------
+    currentGrid = allocateGrid();
+    nextGrid = allocateGrid();
     
-    //  Scaffold 2D arrays on top of the 1D arrays
-    //---------------------------------------------
-    currentGrid2D = (int**) malloc(numRows*sizeof(int*));
-    nextGrid2D = (int**) malloc(numRows*sizeof(int*));
-    currentGrid2D[0] = currentGrid;
-    nextGrid2D[0] = nextGrid;
+    srand(randomSeed);
+    resetGrid();
+}
 
-    for (int i=1; i<numRows; i++) {
-        currentGrid2D[i] = currentGrid2D[i-1] + numCols;
-        nextGrid2D[i] = nextGrid2D[i-1] + numCols;
+/*
+ *------------------------------------------------------------------
+ * Allocates a grid of numRows x numCols cells (plus the halo), all
+ *  dead, in the layout picked with -layout
+ *------------------------------------------------------------------
+ */
+Grid* allocateGrid(void) {
+    Grid* grid = createGrid(numRows, numCols, gridLayout == LAYOUT_TILED ? tileCols : numCols);
+    if(grid == NULL) {
+        printf("%s\n", "Not enough memory for the grid");
+        exit(-1);
     }
-    
-    srand((unsigned int) time(NULL));
-    resetGrid();
+    setHaloRows(grid);
+    return grid;
 }
 
 /*
  *------------------------------------------------------------------
- * Checks an entire row and changes which cells die and which
- *  survive
+ * On a torus, the halo rows are not copies: the scaffold points them
+ *  to the last & first rows.  Otherwise they are the grid's own
+ *  halo rows (dead, or filled by the neighboring processes).
  *------------------------------------------------------------------
  */
-void rowGeneration(int row) {
-    for(int j = 0; j < numCols; j++) {
-        unsigned int newState = cellNewState(row, j);
+void setHaloRows(Grid* grid) {
+    setGridHaloRows(grid, wrapFrame && processRank < 0);
+}
+
+/*
+ *------------------------------------------------------------------
+ * Turns the torus on or off.  Only called between two generations,
+ *  while no thread is computing.
+ *------------------------------------------------------------------
+ */
+void setWrapFrame(int wrap) {
+    if (processRank >= 0 || planeMode)
+        return;
+    wrapFrame = wrap;
+    setHaloRows(currentGrid);
+    setHaloRows(nextGrid);
+    for (unsigned int k=0; k<wavefrontRingSize; k++) {
+        setHaloRows(wavefrontRing[k]);
+    }
+    if (wrapFrame)
+        refreshGridEdges(currentGrid, 1);
+    if (wavefrontRingSize > 0)
+        setWavefrontPeriodic(wrapFrame);
+}
+
+/*
+ *------------------------------------------------------------------
+ * The ring starts with the current & next grids; generation g is
+ *  kept in wavefrontRing[g % wavefrontRingSize]
+ *------------------------------------------------------------------
+ */
+void initializeWavefrontRing(void) {
+    wavefrontRing[generation % wavefrontRingSize] = currentGrid;
+    wavefrontRing[(generation+1) % wavefrontRingSize] = nextGrid;
+    for(unsigned int k = 2; k < wavefrontRingSize; k++) {
+        wavefrontRing[(generation+k) % wavefrontRingSize] = allocateGrid();
+    }
+    initializeWavefront(numThreads, wavefrontRingSize, generation, wrapFrame);
+}
+
+/*
+ *------------------------------------------------------------------
+ * Computes the thread's rows.  With a Larger than Life rule, the
+ *  neighbors are counted for the whole slab first, one row ahead of
+ *  the rows being written.  Otherwise, on a tiled grid, each band is
+ *  swept from the top to the bottom of the slab before the next one,
+ *  so that the rows it reads are still in the cache when they are
+ *  read again (as the row above, then the row below).  On the plane,
+ *  the thread steps its share of the chunks instead.
+ *  Returns the number of cells computed.
+ *------------------------------------------------------------------
+ */
+uint64_t slabGeneration(ThreadInfo* info, const Grid* grid, const Grid* next, GenerationStats* stats) {
+    uint64_t cells = (uint64_t) (info->endIndex - info->startIndex) * numCols;
+    if(planeMode) {
+        int slab = info->index - 1;
+        int first = (int) ((long) plane.numChunks * slab / numThreads);
+        int end = (int) ((long) plane.numChunks * (slab+1) / numThreads);
+        stepPlaneChunks(&plane, first, end, stats);
+        return (uint64_t) (end - first) * CHUNK_SIZE * CHUNK_SIZE;
+    }
+    if(rule == LARGER_THAN_LIFE_RULE) {
+        // the counts come one whole row at a time
+        startBoxSums(&info->boxSums, &largerRule, grid, info->startIndex, numRows, numCols, wrapFrame);
+        for(int i = info->startIndex; i < info->endIndex; i++) {
+            const int* counts = nextBoxSums(&info->boxSums);
+            RowHash rowHash = {0};
+            for(int b = 0; b < grid->numBands; b++) {
+                rowGeneration(grid->band[b], next->band[b], i, grid->firstCol[b], grid->firstCol[b+1],
+                              counts, NULL, stats, &rowHash);
+                shareBandEdges(next, b, i, wrapFrame);
+            }
+        }
+        return cells;
+    }
+    if(info->rowHashes == NULL) {
+        info->rowHashes = (RowHash*) poolAlloc(numRows*sizeof(RowHash));
+    }
+    memset(info->rowHashes + info->startIndex, 0, (info->endIndex - info->startIndex)*sizeof(RowHash));
+    if(blockTableReady && info->blockStates == NULL) {
+        info->blockStates = (unsigned char*) poolAlloc(2*numCols);
+    }
+    for(int b = 0; b < grid->numBands; b++) {
+        int** rows = grid->band[b];
+        int** nextRows = next->band[b];
+        int first = grid->firstCol[b], end = grid->firstCol[b+1];
+        if(!blockTableReady) {
+            for(int i = info->startIndex; i < info->endIndex; i++) {
+                rowGeneration(rows, nextRows, i, first, end, NULL, NULL, stats, info->rowHashes + i);
+                shareBandEdges(next, b, i, wrapFrame);
+            }
+            continue;
+        }
+        unsigned char* top = info->blockStates;
+        unsigned char* bottom = info->blockStates + numCols;
+        for(int i = info->startIndex; i < info->endIndex; i += 2) {
+            int single = (i+1 == info->endIndex);
+            blockRowPair(blockTable, rows, i, first, end, single, top, bottom);
+            for(int k = 0; k < (single ? 1 : 2); k++) {
+                unsigned char* states = k ? bottom : top;
+                // the border dies, as in cellNewState()
+                int globalRow = i + k + globalRowOffset;
+                if(!wrapFrame) {
+                    if(globalRow == 0 || globalRow == globalNumRows-1) {
+                        memset(states + first, 0, end - first);
+                    }
+                    if(first == 0)
+                        states[0] = 0;
+                    if(end == numCols)
+                        states[numCols-1] = 0;
+                }
+                rowGeneration(rows, nextRows, i + k, first, end, NULL, states, stats, info->rowHashes + i + k);
+                shareBandEdges(next, b, i + k, wrapFrame);
+            }
+        }
+    }
+    return cells;
+}
+
+/*
+ *------------------------------------------------------------------
+ * Checks columns firstCol to endCol-1 of a row of grid and writes
+ *  which cells die and which survive into next (counts: live cells
+ *  around each cell of the row, only for Larger than Life rules;
+ *  newStates: the cells' next states, already looked up in the block
+ *  table).  The row's hash is added to the stats with its last column.
+ *------------------------------------------------------------------
+ */
+void rowGeneration(int** grid, int** next, int row, int firstCol, int endCol, const int* counts,
+                   const unsigned char* newStates, GenerationStats* stats, RowHash* rowHash) {
+    unsigned long births = 0, deaths = 0;
+    // liveness of the row, 64 cells at a time, for the cycle detection
+    uint64_t hash = rowHash->hash, aliveBits = rowHash->aliveBits;
+    // with dying states, the state is the color: no ages on top of it
+    int multiState = (ruleStates() > 2);
+    // ... and the states' bits are hashed too, as the batch engine's bit planes
+    // (lifeEngine.c), so that grids only differing in dying states don't look
+    // the same, and both hashes agree
+    int statePlanes = 0;
+    if(multiState) {
+        while((1u << statePlanes) < ruleStates())
+            statePlanes++;
+    }
+    uint64_t stateBits[MAX_RULE_PLANES];
+    for(int p = 0; p < statePlanes; p++)
+        stateBits[p] = rowHash->stateBits[p];
+    for(int j = firstCol; j < endCol; j++) {
+        unsigned int newState = newStates != NULL ? newStates[j] :
+                                counts != NULL ? ltlNewState(grid[row][j], counts[j]) :
+                                rule == CUSTOM_RULE ? customNewState(grid, row, j) :
+                                cellNewState(grid, row, j);
+        int oldState = grid[row][j];
         //    In black and white mode, only alive/dead matters
         //    Dead is dead in any mode
-        if (colorMode == 0 || newState == 0) {
-            nextGrid2D[row][j] = newState;
+        if (colorMode == 0 || newState == 0 || multiState) {
+            next[row][j] = newState;
         }
         //    in color mode, color reflext the "age" of a live cell
         else {
             //    Any cell that has not yet reached the "very old cell"
             //    stage simply got one generation older
-            if (currentGrid2D[row][j] < NB_COLORS-1)
-                nextGrid2D[row][j] = currentGrid2D[row][j] + 1;
+            if (oldState < NB_COLORS-1)
+                next[row][j] = oldState + 1;
             //    An old cell remains old until it dies
             else
-                nextGrid2D[row][j] = currentGrid2D[row][j];
+                next[row][j] = oldState;
         }
+        //    statistics, counted while the cell is still in a register
+        births += (oldState == 0) & (newState != 0);
+        deaths += (oldState != 0) & (newState == 0);
+        stats->stateCount[next[row][j]]++;
+        aliveBits |= (uint64_t) (newState != 0) << (j & 63);
+        for(int p = 0; p < statePlanes; p++)
+            stateBits[p] |= (uint64_t) ((newState >> p) & 1) << (j & 63);
+        if((j & 63) == 63) {
+            hash = mixHash(hash ^ aliveBits);
+            aliveBits = 0;
+            for(int p = 0; p < statePlanes; p++) {
+                hash = mixHash(hash ^ stateBits[p]);
+                stateBits[p] = 0;
+            }
+        }
+    }
+    stats->births += births;
+    stats->deaths += deaths;
+    rowHash->hash = hash;
+    rowHash->aliveBits = aliveBits;
+    for(int p = 0; p < statePlanes; p++)
+        rowHash->stateBits[p] = stateBits[p];
+    // the row index is mixed in so that moving a row changes the hash
+    // (index in the whole grid, so that processes' hashes add up)
+    if(endCol == numCols) {
+        // (the states of the last, partial word go in before its liveness)
+        if((numCols & 63) != 0) {
+            for(int p = 0; p < statePlanes; p++)
+                hash = mixHash(hash ^ stateBits[p]);
+        }
+        stats->hash += mixHash(hash ^ aliveBits ^ (0x9E3779B97F4A7C15ull * (row + globalRowOffset + 1)));
     }
 }
 
@@ -355,69 +1070,582 @@ void rowGeneration(int row) {
  *---------------------------------------------------------------------
  * Each thread will run indefinitely until we exit the application
  *.....................................................................
- * threads change generations for their assigned rows and mutex locks
- *  & semaphores are used for multithreading & keeping all threads
-*   in a phase 
+ * threads change generations for their assigned rows, then wait at
+ *  a barrier (mutex lock + condition) until all threads are done:
+ *  the last one to arrive swaps the grids and releases the others
  *---------------------------------------------------------------------
  */
 void* threadFunc(void* arg) {
     ThreadInfo* info = (ThreadInfo *) arg;
+    ThreadCounters* counters = threadCounters(info->index - 1);
+    char traceName[32];
+    sprintf(traceName, "worker %d", info->index);
+    traceRegisterThread(traceName);
     //  run the threads indefinitely until we stop the program
     while(1) {
+        // our rows of the frame to export, if the last generation has one
+        // (the current grid is only read until the next swap)
+        exportRows(currentGrid, info->startIndex, info->endIndex);
+        traceBegin(TRACE_COMPUTE);
+        uint64_t computeStart = perfNow();
+        uint64_t cpuStart = perfThreadCPU();
+        clearStats(&info->stats[0]);
+        uint64_t cells = slabGeneration(info, currentGrid, nextGrid, &info->stats[0]);
+        uint64_t computeEnd = perfNow();
+        // CPU time, so that threads sharing a core don't look slower than they are
+        recordSlabCost(info->startIndex, info->endIndex, 1e-9*(perfThreadCPU() - cpuStart));
+        traceEnd(TRACE_COMPUTE);
+        info->computeTime = 1e-9*(computeEnd - computeStart);
+        counters->computeNs += computeEnd - computeStart;
+        counters->cellsProcessed += cells;
+        counters->generations++;
+
+        traceBegin(TRACE_WAIT);
         pthread_mutex_lock(&myLock);
-        // only allow one "row" to be changed at a time
-        for(int i = info->startIndex; i < info->endIndex; i++) {
-            rowGeneration(i);
-            usleep(applicationSpeed);
-        }
-        sem_wait(&mutex);
         swapCounter++;
         // once all threads have executed we swap
         if(swapCounter == numThreads) {
+            traceEnd(TRACE_WAIT);
+            traceBegin(TRACE_SWAP);
             swapGrids();
             swapCounter = 0;
+            completeGeneration(0);
+            traceEnd(TRACE_SWAP);
+            // everybody is waiting anyway: this is where we keep the pace
+            traceBegin(TRACE_PACE);
+            pacingSleepNs = paceGeneration();
+            traceEnd(TRACE_PACE);
+            barrierPhase++;
+            pthread_cond_broadcast(&generationDone);
+        } else {
+            unsigned long myPhase = barrierPhase;
+            while(myPhase == barrierPhase) {
+                pthread_cond_wait(&generationDone, &myLock);
+            }
+            traceEnd(TRACE_WAIT);
         }
-        sem_post(&mutex);
+        // the time spent pacing counts as sleep, not as synchronization
+        uint64_t pacing = pacingSleepNs;
         // we are done so raise the lock
         pthread_mutex_unlock(&myLock);
+        uint64_t waited = perfNow() - computeEnd;
+        counters->syncWaitNs += waited > pacing ? waited - pacing : 0;
+        counters->sleepNs += pacing;
+    }
+    return NULL;
+}
+
+/*
+ *---------------------------------------------------------------------
+ * Same as threadFunc, without the barrier: a thread computes the next
+ *  generation of its rows as soon as the slabs above & below are done
+ *  with the current one.  The thread whose slab finishes a generation
+ *  last completes it (stats, export, commands, pacing).
+ *---------------------------------------------------------------------
+ */
+void* wavefrontThreadFunc(void* arg) {
+    ThreadInfo* info = (ThreadInfo *) arg;
+    ThreadCounters* counters = threadCounters(info->index - 1);
+    int slab = info->index - 1;
+    unsigned long gen = generation;
+    char traceName[32];
+    sprintf(traceName, "worker %d", info->index);
+    traceRegisterThread(traceName);
+    while(1) {
+        gen++;
+        traceBegin(TRACE_WAIT);
+        uint64_t waitStart = perfNow();
+        waitForNeighbors(slab, gen);
+        traceEnd(TRACE_WAIT);
+
+        traceBegin(TRACE_COMPUTE);
+        uint64_t computeStart = perfNow();
+        const Grid* grid = wavefrontRing[(gen-1) % wavefrontRingSize];
+        const Grid* next = wavefrontRing[gen % wavefrontRingSize];
+        GenerationStats* stats = &info->stats[gen % wavefrontRingSize];
+        clearStats(stats);
+        uint64_t cells = slabGeneration(info, grid, next, stats);
+        uint64_t computeEnd = perfNow();
+        traceEnd(TRACE_COMPUTE);
+        info->computeTime = 1e-9*(computeEnd - computeStart);
+        counters->computeNs += computeEnd - computeStart;
+        counters->syncWaitNs += computeStart - waitStart;
+        counters->cellsProcessed += cells;
+        counters->generations++;
+
+        unsigned long toComplete = finishSlab(slab, gen);
+        while(toComplete != 0) {
+            traceBegin(TRACE_SWAP);
+            uint64_t completeStart = perfNow();
+            completeWavefrontGeneration(toComplete);
+            counters->syncWaitNs += perfNow() - completeStart;
+            traceEnd(TRACE_SWAP);
+            traceBegin(TRACE_PACE);
+            counters->sleepNs += paceGeneration();
+            traceEnd(TRACE_PACE);
+            toComplete = generationCompleted(toComplete);
+        }
     }
     return NULL;
 }
 
+/*
+ *------------------------------------------------------------------
+ * Called by the thread that finished the last rows of a generation,
+ *  right after the swap, while the other threads are waiting
+ *------------------------------------------------------------------
+ */
+void completeGeneration(int statsSlot) {
+    generation++;
+    exchangeHalos();
+    if(fastForwardRemaining > 0)
+        fastForwardRemaining--;
+
+    // add up the counts of all the threads
+    GenerationStats totals;
+    clearStats(&totals);
+    for(int i = 0; i < numThreads; i++) {
+        addStats(&totals, &threads[i].stats[statsSlot]);
+    }
+    totals.generation = generation;
+    for(int k = 1; k < MAX_CELL_STATES; k++) {
+        totals.population += totals.stateCount[k];
+    }
+    publishStats(&totals);
+    writeStatsCSV(&totals);
+    // the workers copy their rows of the frame while they compute the next
+    // generation; with the wavefront, the other slabs don't wait for us
+    if(wavefrontRingSize > 0)
+        exportGeneration(currentGrid, generation);
+    else
+        scheduleExport(generation);
+    rebalanceThreads();
+    traceBegin(TRACE_COMMAND);
+    if(wavefrontRingSize > 0)
+        applyWavefrontCommands();
+    else
+        applyPendingCommands();
+    traceEnd(TRACE_COMMAND);
+
+    double now = currentTime();
+    if(now - rateStartTime >= 0.5) {
+        generationRate = (generation - rateStartGeneration) / (now - rateStartTime);
+        rateStartTime = now;
+        rateStartGeneration = generation;
+    }
+
+    if(maxGenerations > 0 && generation >= maxGenerations) {
+        flushScheduledExport(currentGrid);
+        exit(0);
+    }
+
+    // a band of rows may repeat while the whole grid doesn't
+    unsigned int period = processRank < 0 ? recordGenerationHash(totals.hash, generation) : 0;
+    if(period > 0) {
+        handleCycle(period, totals.population);
+    }
+}
+
+/*
+ *------------------------------------------------------------------
+ * When the grid is split between processes, sends our edge rows of
+ *  the current generation to the processes above & below, and gets
+ *  theirs in our halo rows (waiting for them if need be)
+ *------------------------------------------------------------------
+ */
+void exchangeHalos(void) {
+    // the rows of a tiled grid are in pieces: they go through contiguous copies
+    static int* edgeRows = NULL;
+    if(haloTransport == NULL)
+        return;
+    if(currentGrid->numBands == 1) {
+        int** rows = currentGrid->band[0];
+        haloTransport->exchange(rows[0] - 1, rows[numRows-1] - 1,
+                                rows[-1] - 1, rows[numRows] - 1, generation);
+        return;
+    }
+    int length = numCols + 2;
+    if(edgeRows == NULL) {
+        edgeRows = (int*) malloc(4*length*sizeof(int));
+    }
+    copyGridRow(currentGrid, 0, edgeRows);
+    copyGridRow(currentGrid, numRows-1, edgeRows + length);
+    // (halo rows without a neighbor are left as they are)
+    copyGridRow(currentGrid, -1, edgeRows + 2*length);
+    copyGridRow(currentGrid, numRows, edgeRows + 3*length);
+    haloTransport->exchange(edgeRows, edgeRows + length,
+                            edgeRows + 2*length, edgeRows + 3*length, generation);
+    copyIntoGridRow(currentGrid, -1, edgeRows + 2*length);
+    copyIntoGridRow(currentGrid, numRows, edgeRows + 3*length);
+}
+
+/*
+ *------------------------------------------------------------------
+ * Completes a generation all slabs are done with.  Slabs may already
+ *  be working on the next ones, in other buffers of the ring.
+ *------------------------------------------------------------------
+ */
+void completeWavefrontGeneration(unsigned long gen) {
+    currentGrid = wavefrontRing[gen % wavefrontRingSize];
+    nextGrid = wavefrontRing[(gen+1) % wavefrontRingSize];
+    completeGeneration(gen % wavefrontRingSize);
+}
+
+/*
+ *------------------------------------------------------------------
+ * A command (or mouse edit) must take effect at the same generation
+ *  in every slab, and a reset rewrites the whole grid: hold the slabs
+ *  at the highest generation one of them has reached, and apply the
+ *  commands once the others have caught up and that generation is
+ *  completed.
+ *------------------------------------------------------------------
+ */
+void applyWavefrontCommands(void) {
+    if(heldGeneration() == 0 && inputPending()) {
+        holdWavefront();
+    }
+    if(heldGeneration() != 0 && heldGeneration() == generation) {
+        applyPendingCommands();
+        // a reset swaps the current & next grids: so does the ring
+        unsigned int current = generation % wavefrontRingSize;
+        unsigned int following = (generation+1) % wavefrontRingSize;
+        if(currentGrid != wavefrontRing[current]) {
+            wavefrontRing[following] = wavefrontRing[current];
+            wavefrontRing[current] = currentGrid;
+        }
+        releaseWavefront();
+    }
+}
+
+/*
+ *------------------------------------------------------------------
+ * Sleeps until the deadline of the generation that just completed,
+ *  so that we produce targetRate generations per second whatever
+ *  the grid size & number of threads.  The deadlines are absolute:
+ *  time spent computing is not added on top of the sleep, and a
+ *  late generation doesn't delay the following ones.
+ * Returns the time slept, in ns.
+ *------------------------------------------------------------------
+ */
+uint64_t paceGeneration(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if(targetRate <= 0.0 || fastForwardRemaining > 0) {
+        nextDeadline = now;
+        return 0;
+    }
+
+    uint64_t period = (uint64_t) (1e9 / targetRate);
+    uint64_t deadline = (uint64_t) nextDeadline.tv_sec * 1000000000u + nextDeadline.tv_nsec + period;
+    uint64_t current = (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+    // more than a period late (or just started): don't try to catch up
+    if(deadline + period < current) {
+        deadline = current;
+    }
+    nextDeadline.tv_sec = deadline / 1000000000u;
+    nextDeadline.tv_nsec = deadline % 1000000000u;
+
+    if(deadline <= current)
+        return 0;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &nextDeadline, NULL) == EINTR)
+        ;
+    return deadline - current;
+}
+
+/*
+ *------------------------------------------------------------------
+ * Moves the boundaries between the threads' rows when some threads
+ *  have had noticeably more work than the others.  Only called at
+ *  the barrier, while no thread is computing.
+ *------------------------------------------------------------------
+ */
+void rebalanceThreads(void) {
+    int boundaries[numThreads+1];
+    for(int i = 0; i < numThreads; i++) {
+        boundaries[i] = threads[i].startIndex;
+    }
+    boundaries[numThreads] = numRows;
+    if(rebalanceSlabs(boundaries)) {
+        for(int i = 0; i < numThreads; i++) {
+            threads[i].startIndex = boundaries[i];
+            threads[i].endIndex = boundaries[i+1];
+        }
+    }
+}
+
+/*
+ *------------------------------------------------------------------
+ * The grid went back to a state it was in `period` generations ago:
+ *  from now on the workers would only repeat themselves
+ *------------------------------------------------------------------
+ */
+void handleCycle(unsigned int period, unsigned long population) {
+    if(cycleAction == CYCLE_LOG || cycleAction == CYCLE_STOP) {
+        fprintf(stderr, "generation %lu: %s, period %u\n", generation,
+                population == 0 ? "extinct" : "cycle detected", period);
+    }
+
+    switch(cycleAction) {
+        case CYCLE_LOG:
+            break;
+
+        case CYCLE_STOP:
+            flushScheduledExport(currentGrid);
+            exit(0);
+            break;
+
+        // the other workers are waiting at the barrier: keep them there,
+        // asleep, until some command (reset, rule change...) or edit comes in
+        case CYCLE_PARK:
+            workersParked = 1;
+            while(workersParked) {
+                waitForCommands(inputPending);
+                // with the wavefront, commands wait for all slabs to catch up
+                if(wavefrontRingSize > 0 || applyPendingCommands() > 0)
+                    workersParked = 0;
+            }
+            break;
+
+        case CYCLE_RESET:
+            // (other slabs may be ahead: they must be held first)
+            if(wavefrontRingSize > 0) {
+                pushCommand("reset");
+            } else {
+                resetGrid();
+                clearCycleHistory();
+            }
+            break;
+    }
+}
+
+/*
+ *------------------------------------------------------------------
+ * Answers a query from the control socket with one line of JSON.
+ *  Only reads values published by the simulation, so the worker
+ *  threads never wait on a client.
+ *------------------------------------------------------------------
+ */
+int queryToJSON(const char* query, char* reply, size_t replySize) {
+    int all = (strcmp(query, "stats") == 0);
+    int wantGeneration = all || strcmp(query, "generation") == 0;
+    int wantPopulation = all || strcmp(query, "population") == 0;
+    int wantRate = all || strcmp(query, "rate") == 0;
+    int wantThreads = all || strcmp(query, "threads") == 0;
+    int wantRule = all || strcmp(query, "rule") == 0;
+    int wantCycle = all || strcmp(query, "cycle") == 0;
+    int wantMemory = all || strcmp(query, "memory") == 0;
+
+    if(!(wantGeneration || wantPopulation || wantRate || wantThreads || wantRule || wantCycle || wantMemory))
+        return 0;
+
+    size_t n = 0;
+    n += snprintf(reply + n, replySize - n, "{");
+    if(wantGeneration && n < replySize) {
+        n += snprintf(reply + n, replySize - n, "\"generation\":%lu,", generation);
+    }
+    if(wantPopulation && n < replySize) {
+        GenerationStats stats;
+        readStats(&stats);
+        n += snprintf(reply + n, replySize - n, "\"population\":%lu,\"births\":%lu,\"deaths\":%lu,\"states\":[",
+                      stats.population, stats.births, stats.deaths);
+        for(int k = 0; k < (int) cellStateCount() && n < replySize; k++) {
+            n += snprintf(reply + n, replySize - n, "%s%lu", k > 0 ? "," : "", stats.stateCount[k]);
+        }
+        if(n < replySize)
+            n += snprintf(reply + n, replySize - n, "],");
+    }
+    if(wantRate && n < replySize) {
+        n += snprintf(reply + n, replySize - n, "\"gensPerSec\":%.2f,\"targetGensPerSec\":%.2f,",
+                      generationRate, targetRate);
+    }
+    if(wantThreads && n < replySize) {
+        n += snprintf(reply + n, replySize - n, "\"threads\":[");
+        for(int i = 0; i < numThreads && n < replySize; i++) {
+            ThreadCounters* counters = threadCounters(i);
+            n += snprintf(reply + n, replySize - n, "%s{\"index\":%d,\"rows\":[%d,%d],\"computeMs\":%.3f,"
+                          "\"totalComputeMs\":%.1f,\"totalSyncWaitMs\":%.1f,\"totalSleepMs\":%.1f,"
+                          "\"cells\":%llu,\"generations\":%llu}",
+                          i > 0 ? "," : "", threads[i].index, threads[i].startIndex,
+                          threads[i].endIndex, 1000.0*threads[i].computeTime,
+                          1e-6*counters->computeNs, 1e-6*counters->syncWaitNs, 1e-6*counters->sleepNs,
+                          (unsigned long long) counters->cellsProcessed,
+                          (unsigned long long) counters->generations);
+        }
+        if(n < replySize)
+            n += snprintf(reply + n, replySize - n, "],\"rebalances\":%lu,", rebalanceCount());
+    }
+    if(wantRule && n < replySize) {
+        n += snprintf(reply + n, replySize - n, "\"rule\":%u,\"ruleName\":\"%s\",\"colorMode\":%u,\"boundary\":\"%s\",",
+                      rule, rule == CUSTOM_RULE ? customRuleName : RULE_NAME[rule], colorMode,
+                      wrapFrame ? "wrap" : "dead");
+    }
+    if(wantCycle && n < replySize) {
+        GenerationStats stats;
+        readStats(&stats);
+        CycleInfo cycle = currentCycle();
+        n += snprintf(reply + n, replySize - n, "\"hash\":\"%016llx\",\"period\":%u,\"cycleDetectedAt\":%lu,"
+                      "\"onCycle\":\"%s\",\"parked\":%s,",
+                      (unsigned long long) stats.hash, cycle.period, cycle.detectedAt,
+                      cycleActionName(cycleAction), workersParked ? "true" : "false");
+    }
+    if(wantMemory && n < replySize) {
+        PoolStats pool;
+        readPoolStats(&pool);
+        n += snprintf(reply + n, replySize - n, "\"pool\":{\"allocations\":%llu,\"frees\":%llu,\"hitRate\":%.4f,"
+                      "\"globalRefills\":%llu,\"globalReleases\":%llu,\"systemRuns\":%llu,\"largeAllocations\":%llu,"
+                      "\"requestedBytes\":%llu,\"reservedBytes\":%llu,\"fragmentation\":%.4f},",
+                      (unsigned long long) pool.allocations, (unsigned long long) pool.frees, pool.hitRate,
+                      (unsigned long long) pool.globalRefills, (unsigned long long) pool.globalReleases,
+                      (unsigned long long) pool.systemRuns, (unsigned long long) pool.largeAllocations,
+                      (unsigned long long) pool.requestedBytes, (unsigned long long) pool.reservedBytes,
+                      pool.fragmentation);
+    }
+    // replace the trailing comma
+    if(n < replySize)
+        reply[n-1] = '}';
+    else
+        snprintf(reply, replySize, "{\"ok\":false,\"error\":\"reply too long\"}");
+    return 1;
+}
+
+/*
+ *------------------------------------------------------------------
+ * Monotonic clock, in seconds
+ *------------------------------------------------------------------
+ */
+double currentTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + 1e-9*now.tv_nsec;
+}
+
+/*
+ *------------------------------------------------------------------
+ * Registered with atexit() so that every exit path (ESC, "end",
+ *  generation limit) lets the encoders finish their frames
+ *------------------------------------------------------------------
+ */
+void shutdownApplication(void) {
+    shutdownExport();
+    writeTrace();
+    closeStatsCSV();
+
+    GenerationStats stats;
+    readStats(&stats);
+    if(processRank >= 0) {
+        ProcessResult result = {processRank, stats.generation, stats.population, stats.hash};
+        reportProcessResult(&result);
+        haloTransport->detach();
+    } else if(headless) {
+        fprintf(stderr, "generation %lu: population %lu, hash %016llx\n",
+                stats.generation, stats.population, (unsigned long long) stats.hash);
+        PoolStats pool;
+        readPoolStats(&pool);
+        fprintf(stderr, "pool: %llu allocations, hit rate %.1f%%, %llu calls to malloc, fragmentation %.1f%%\n",
+                (unsigned long long) pool.allocations, 100.0*pool.hitRate,
+                (unsigned long long) (pool.systemRuns + pool.largeAllocations), 100.0*pool.fragmentation);
+    }
+}
+
 /*
  *------------------------------------------------------------------
  *  Randomizes the grid at launch and everytime spacebar is pressed
  *------------------------------------------------------------------
  */
 void resetGrid(void) {
-    for (int i = 0; i < numRows; i++) {
+    // the plane gets the same cells, where the window starts
+    if (planeMode) {
+        clearPlane(&plane);
+        viewRow = viewCol = 0;
+    }
+    // a process sharing the grid draws all of it and keeps its own rows,
+    // so the grid only depends on the seed
+    for (int globalRow = 0; globalRow < globalNumRows; globalRow++) {
+        int i = globalRow - globalRowOffset;
         for (int j = 0; j < numCols; j++) {
-            nextGrid2D[i][j] = rand() % 2;
+            // (a coin flip at the default density, so that the grid of a
+            // seed stays the same)
+            int state = (initialDensity == 50) ? rand() % 2 : (rand() % 100 < initialDensity);
+            if (planeMode && state)
+                setPlaneCell(&plane, globalRow, j, 1);
+            else if (i >= 0 && i < numRows)
+                *gridCell(nextGrid, i, j) = state;
         }
     }
+    if (planeMode) {
+        tidyPlane(&plane);
+        copyPlaneWindow(&plane, viewRow, viewCol, currentGrid);
+        return;
+    }
+    refreshGridEdges(nextGrid, wrapFrame);
     swapGrids();
 }
 
 /*
  *------------------------------------------------------------------
- *    This function swaps the current and next grids, as well as their
- *    companion 2D grid.  Note that we only swap the "top" layer of
- *    the 2D grids.
+ *    This function swaps the current and next grids (their cells and
+ *    row scaffolds go together)
  *------------------------------------------------------------------
  */
 void swapGrids(void) {
+    if (planeMode) {
+        finishPlaneGeneration();
+        return;
+    }
     // swap grids
-    int* tempGrid;
-    int** tempGrid2D;
+    Grid* tempGrid;
     
     tempGrid = currentGrid;
     currentGrid = nextGrid;
     nextGrid = tempGrid;
+}
+/*
+ *------------------------------------------------------------------
+ * Called by the last thread done with a generation on the plane: the
+ *  next generation becomes the current one, and the window gets its
+ *  states (unless nobody will look at them), after moving so that the
+ *  middle of the live cells stays in its middle if it follows them
+ *------------------------------------------------------------------
+ */
+void finishPlaneGeneration(void) {
+    advancePlane(&plane);
+    if (followLiveCells)
+        centerPlaneWindow();
+    if (!headless || exportOptions.interval > 0)
+        copyPlaneWindow(&plane, viewRow, viewCol, currentGrid);
+}
+
+/*
+ *------------------------------------------------------------------
+ * "view" & "follow" commands: moves the window onto the plane by whole
+ *  cells, or makes it follow the live cells (or stop), between two
+ *  generations like the edits made in it
+ *------------------------------------------------------------------
+ */
+void centerPlaneWindow(void) {
+    if (plane.minRow <= plane.maxRow) {
+        viewRow = (plane.minRow + plane.maxRow) / 2 - numRows / 2;
+        viewCol = (plane.minCol + plane.maxCol) / 2 - numCols / 2;
+    }
+}
 
-    tempGrid2D = currentGrid2D;
-    currentGrid2D = nextGrid2D;
-    nextGrid2D = tempGrid2D;
+void movePlaneWindow(long rows, long cols) {
+    if (!planeMode)
+        return;
+    viewRow += rows;
+    viewCol += cols;
+    copyPlaneWindow(&plane, viewRow, viewCol, currentGrid);
 }
+
+void setFollowLiveCells(int follow) {
+    followLiveCells = follow;
+    if (planeMode && follow) {
+        centerPlaneWindow();
+        copyPlaneWindow(&plane, viewRow, viewCol, currentGrid);
+    }
+}
+
 /*
  *------------------------------------------------------------------
  *    The quick implementation I did in class is not good because it keeps
@@ -427,7 +1655,7 @@ void swapGrids(void) {
  *    I also refer explicitly to the S/B elements of the "rule" in place.
  *------------------------------------------------------------------
 */
-unsigned int cellNewState(unsigned int i, unsigned int j) {
+unsigned int cellNewState(int** grid, int i, int j) {
     // First count the number of neighbors that are alive
     //----------------------------------------------------
     //  Again, this implementation makes no pretense at being the most efficient.
@@ -436,16 +1664,19 @@ unsigned int cellNewState(unsigned int i, unsigned int j) {
     
     // Away from the border, we simply count how many among the cell's
     // eight neighbors are alive (cell state > 0)
-    if (i > 0 && i < numRows-1 && j > 0 && j < numCols-1) {
+    // (the border is the one of the whole grid, when it is split between processes;
+    // a torus has no border: the halo holds the cells from the other side)
+    int globalRow = i + globalRowOffset;
+    if (wrapFrame || (globalRow > 0 && globalRow < globalNumRows-1 && j > 0 && j < numCols-1)) {
         // remember that in C, (x == val) is either 1 or 0
-        count = (currentGrid2D[i-1][j-1] != 0) +
-        (currentGrid2D[i-1][j] != 0) +
-        (currentGrid2D[i-1][j+1] != 0)  +
-        (currentGrid2D[i][j-1] != 0)  +
-        (currentGrid2D[i][j+1] != 0)  +
-        (currentGrid2D[i+1][j-1] != 0)  +
-        (currentGrid2D[i+1][j] != 0)  +
-        (currentGrid2D[i+1][j+1] != 0);
+        count = (grid[i-1][j-1] != 0) +
+        (grid[i-1][j] != 0) +
+        (grid[i-1][j+1] != 0)  +
+        (grid[i][j-1] != 0)  +
+        (grid[i][j+1] != 0)  +
+        (grid[i+1][j-1] != 0)  +
+        (grid[i+1][j] != 0)  +
+        (grid[i+1][j+1] != 0);
     }
     // on the border of the frame...
     else {
@@ -458,44 +1689,33 @@ unsigned int cellNewState(unsigned int i, unsigned int j) {
         
 #elif FRAME_BEHAVIOR == FRAME_CLIPPED
         
-        if (i > 0) {
-            if (j>0 && currentGrid2D[i-1][j-1] != 0)
+        if (globalRow > 0) {
+            if (j>0 && grid[i-1][j-1] != 0)
                 count++;
-            if (currentGrid2D[i-1][j] != 0)
+            if (grid[i-1][j] != 0)
                 count++;
-            if (j<numCols-1 && currentGrid2D[i-1][j+1] != 0)
+            if (j<numCols-1 && grid[i-1][j+1] != 0)
                 count++;
         }
     
-        if (j>0 && currentGrid2D[i][j-1] != 0)
+        if (j>0 && grid[i][j-1] != 0)
             count++;
-        if (j<numCols-1 && currentGrid2D[i][j+1] != 0)
+        if (j<numCols-1 && grid[i][j+1] != 0)
             count++;
         
-        if (i<numRows-1) {
-            if (j>0 && currentGrid2D[i+1][j-1] != 0)
+        if (globalRow < globalNumRows-1) {
+            if (j>0 && grid[i+1][j-1] != 0)
                 count++;
-            if (currentGrid2D[i+1][j] != 0)
+            if (grid[i+1][j] != 0)
                 count++;
-            if (j<numCols-1 && currentGrid2D[i+1][j+1] != 0)
+            if (j<numCols-1 && grid[i+1][j+1] != 0)
                 count++;
         }
         
         
-#elif FRAME_BEHAVIOR == FRAME_WRAPPED
-        
-        unsigned int     iM1 = (i+numRows-1)%numRows,
-        iP1 = (i+1)%numRows,
-        jM1 = (j+numCols-1)%numCols,
-        jP1 = (j+1)%numCols;
-        count = currentGrid2D[iM1][jM1] != 0 +
-        currentGrid2D[iM1][j] != 0 +
-        currentGrid2D[iM1][jP1] != 0  +
-        currentGrid2D[i][jM1] != 0  +
-        currentGrid2D[i][jP1] != 0  +
-        currentGrid2D[iP1][jM1] != 0  +
-        currentGrid2D[iP1][j] != 0  +
-        currentGrid2D[iP1][jP1] != 0 ;
+#elif FRAME_BEHAVIOR == FRAME_WRAP
+        // only reached once wrapping was turned off: border cells die
+        count = -1;
         
 #else
 #error undefined frame behavior
@@ -515,7 +1735,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j) {
         case GAME_OF_LIFE_RULE:
             
             //    if the cell is currently occupied by a live cell, look at "Stay alive rule"
-            if (currentGrid2D[i][j] != 0) {
+            if (grid[i][j] != 0) {
                 if (count == 3 || count == 2)
                     newState = 1;
             }
@@ -530,7 +1750,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j) {
         case CORAL_GROWTH_RULE:
             
             //    if the cell is currently occupied by a live cell, look at "Stay alive rule"
-            if (currentGrid2D[i][j] != 0) {
+            if (grid[i][j] != 0) {
                 if (count > 3)
                     newState = 1;
             }
@@ -545,7 +1765,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j) {
         case AMOEBA_RULE:
             
             //    if the cell is currently occupied by a live cell, look at "Stay alive rule"
-            if (currentGrid2D[i][j] != 0) {
+            if (grid[i][j] != 0) {
                 if (count == 1 || count == 3 || count == 5 || count == 8)
                     newState = 1;
             }
@@ -560,7 +1780,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j) {
         case MAZE_RULE:
             
             // if the cell is currently occupied by a live cell, look at "Stay alive rule"
-            if (currentGrid2D[i][j] != 0) {
+            if (grid[i][j] != 0) {
                 if (count >= 1 && count <= 5)
                     newState = 1;
             }
@@ -580,3 +1800,184 @@ unsigned int cellNewState(unsigned int i, unsigned int j) {
     
     return newState;
 }
+
+/*
+ *------------------------------------------------------------------
+ * Same as cellNewState(), for a rule given as B/S or B/S/C.  With
+ *  more than 2 states, only the live cells (state 1) count as
+ *  neighbors, a live cell that doesn't survive starts dying, and the
+ *  dying cells (2 to states-1) age until they are dead again.
+ *  The neighbors are the rule's neighborhood: the 8 around the cell,
+ *  the 4 orthogonal ones, or the 6 of a hexagonal lattice, whose odd
+ *  rows (counted in the whole grid) are shifted half a cell right.
+ *  A non-totalistic rule looks its 3x3 neighborhood up in the rule's
+ *  512 transitions instead of counting.
+ *------------------------------------------------------------------
+ */
+unsigned int customNewState(int** grid, int i, int j) {
+    int state = grid[i][j];
+    unsigned int states = customRule.states;
+    if (states > 2 && state > 1)
+        return state+1 < (int) states ? state+1 : 0;
+    
+    int globalRow = i + globalRowOffset;
+    if (!wrapFrame && !(globalRow > 0 && globalRow < globalNumRows-1 && j > 0 && j < numCols-1))
+        return 0;
+    
+    // live: any age, or only state 1 when there are dying states
+    // (state-1 is below the span, without a branch)
+    unsigned int span = (states > 2) ? 1 : NB_COLORS-1;
+#define LIVE(row, col)  ((unsigned int) (grid[row][col] - 1) < span)
+    int alive;
+    if (customRule.isotropic) {
+        unsigned int index = (LIVE(i-1, j-1) << 8) | (LIVE(i-1, j) << 7) | (LIVE(i-1, j+1) << 6) |
+                             (LIVE(i, j-1) << 5) | ((state != 0) << 4) | (LIVE(i, j+1) << 3) |
+                             (LIVE(i+1, j-1) << 2) | (LIVE(i+1, j) << 1) | LIVE(i+1, j+1);
+        alive = (customRule.transitions[index / 64] >> (index % 64)) & 1;
+    } else {
+        int count;
+        switch (customRule.neighborhood) {
+            case NEIGHBORHOOD_VON_NEUMANN:
+                count = LIVE(i-1, j) + LIVE(i, j-1) + LIVE(i, j+1) + LIVE(i+1, j);
+                break;
+            case NEIGHBORHOOD_HEX: {
+                // the two cells above & below that touch this one
+                int left = j - 1 + (globalRow & 1);
+                count = LIVE(i-1, left) + LIVE(i-1, left+1) + LIVE(i, j-1) + LIVE(i, j+1) +
+                        LIVE(i+1, left) + LIVE(i+1, left+1);
+                break;
+            }
+            default:
+                count = LIVE(i-1, j-1) + LIVE(i-1, j) + LIVE(i-1, j+1) +
+                        LIVE(i, j-1) + LIVE(i, j+1) +
+                        LIVE(i+1, j-1) + LIVE(i+1, j) + LIVE(i+1, j+1);
+                break;
+        }
+        alive = (((state == 0) ? customRule.birth : customRule.survival) >> count) & 1;
+    }
+#undef LIVE
+    
+    if (state == 0 || alive)
+        return alive;
+    return states > 2 ? 2 : 0;
+}
+
+/*
+ *------------------------------------------------------------------
+ * Switches to a rule given as 1 - 4, B/S or B/S/C (ending with V or H
+ *  for the von Neumann or hex neighborhoods), or Larger than Life.
+ *  Returns 0 if the text is not a rule.  Called between two generations.
+ *------------------------------------------------------------------
+ */
+int setCustomRule(const char* text) {
+    LtlRule newLargerRule;
+    if (parseLtlRule(text, &newLargerRule)) {
+        if (!ltlRuleFits(&newLargerRule))
+            return 0;
+        largerRule = newLargerRule;
+        ltlRuleName(&largerRule, customRuleName);
+        rule = LARGER_THAN_LIFE_RULE;
+        updateBlockTable();
+        return 1;
+    }
+    LifeRule newRule;
+    if (!parseRule(text, &newRule) || newRule.states > MAX_CELL_STATES)
+        return 0;
+    if (planeMode && !planeRuleFits(&newRule))
+        return 0;
+    if (text[0] >= '1' && text[0] <= '4' && text[1] == '\0') {
+        rule = text[0] - '0';
+    } else {
+        customRule = newRule;
+        ruleName(customRule, customRuleName);
+        rule = CUSTOM_RULE;
+    }
+    updateBlockTable();
+    if (planeMode)
+        setPlaneRule(&plane, newRule);
+    return 1;
+}
+
+/*
+ *------------------------------------------------------------------
+ * The current rule as a B/S rule (meaningless for Larger than Life)
+ *------------------------------------------------------------------
+ */
+LifeRule currentLifeRule(void) {
+    LifeRule lifeRule = customRule;
+    if (rule >= GAME_OF_LIFE_RULE && rule <= MAZE_RULE) {
+        char number[2] = {'0' + rule, '\0'};
+        parseRule(number, &lifeRule);
+    }
+    return lifeRule;
+}
+
+/*
+ *------------------------------------------------------------------
+ * Fills the block table for the current rule, if it suits it.  Called
+ *  whenever the rule changes (between two generations).
+ *------------------------------------------------------------------
+ */
+void updateBlockTable(void) {
+    LifeRule tableRule = currentLifeRule();
+    blockTableReady = blockTableAllowed && rule != LARGER_THAN_LIFE_RULE && blockTableFits(&tableRule);
+    if (blockTableReady)
+        buildBlockTable(blockTable, &tableRule);
+}
+
+//  Number of states the cells can be in with the current rule & color mode
+unsigned int cellStateCount(void) {
+    return ruleStates() > 2 ? ruleStates() : NB_COLORS;
+}
+
+//  1 if the cells are on a hexagonal lattice (drawn with odd rows shifted)
+int hexLattice(void) {
+    return rule == CUSTOM_RULE && customRule.neighborhood == NEIGHBORHOOD_HEX;
+}
+
+//  Number of states of the current rule (2 for the built-in ones)
+unsigned int ruleStates(void) {
+    if (rule == CUSTOM_RULE)
+        return customRule.states;
+    if (rule == LARGER_THAN_LIFE_RULE)
+        return largerRule.states;
+    return 2;
+}
+
+/*
+ *------------------------------------------------------------------
+ * New state of a cell under the Larger than Life rule, from the number
+ *  of live cells in its box (itself included).  Cells near the edges
+ *  of a grid that isn't wrapped simply have dead cells outside.
+ *------------------------------------------------------------------
+ */
+unsigned int ltlNewState(int state, int count) {
+    if (largerRule.states > 2 && state > 1)
+        return state+1 < largerRule.states ? state+1 : 0;
+    if (state == 0)
+        return count >= largerRule.birthLow && count <= largerRule.birthHigh;
+    if (!largerRule.middle)
+        count--;
+    if (count >= largerRule.survivalLow && count <= largerRule.survivalHigh)
+        return 1;
+    return largerRule.states > 2 ? 2 : 0;
+}
+
+/*
+ *------------------------------------------------------------------
+ * The box must fit in the grid, and in the halo rows that the threads
+ *  read from each other: the processes only have one, the wavefront's
+ *  slabs one slab above & below.
+ *------------------------------------------------------------------
+ */
+int ltlRuleFits(const LtlRule* newRule) {
+    int span = 2*newRule->radius + 1;
+    if (span > globalNumRows || span > numCols || newRule->states > MAX_CELL_STATES ||
+        numProcesses > 1 || planeMode)
+        return 0;
+    if (wavefrontRingSize > 0) {
+        int slabs = maxNumThreads < numRows ? maxNumThreads : numRows;
+        return numRows / slabs >= newRule->radius;
+    }
+    return 1;
+}
@@ -0,0 +1,90 @@
+//
+//  perfCounters.c
+//  Cellular Automaton
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "perfCounters.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+PaddedCounters* counterSlots = NULL;
+unsigned int numCounterSlots = 0;
+
+//	previous sample, kept by samplePerformance()
+ThreadCounters* previousCounters = NULL;
+uint64_t previousSampleTime = 0;
+unsigned long previousGeneration = 0;
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void initializePerfCounters(unsigned int numThreads) {
+	numCounterSlots = numThreads;
+	counterSlots = (PaddedCounters*) aligned_alloc(CACHE_LINE_SIZE, numThreads*sizeof(PaddedCounters));
+	memset(counterSlots, 0, numThreads*sizeof(PaddedCounters));
+	previousCounters = (ThreadCounters*) calloc(numThreads, sizeof(ThreadCounters));
+	previousSampleTime = perfNow();
+}
+
+ThreadCounters* threadCounters(unsigned int threadIndex) {
+	return &counterSlots[threadIndex].counters;
+}
+
+uint64_t perfNow(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+uint64_t perfThreadCPU(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	The counters are read without any synchronization: each is a single
+ *	aligned 64-bit word, so at worst we see the value from one generation
+ *	earlier, which is fine for a display.
+ *---------------------------------------------------------------------------
+ */
+void samplePerformance(PerfSummary* summary, unsigned long generation) {
+	if (counterSlots == NULL)
+		return;
+
+	uint64_t now = perfNow();
+	double wall = 1e-9 * (now - previousSampleTime);
+	if (wall <= 0.0)
+		return;
+
+	uint64_t compute = 0, wait = 0, sleep = 0, cells = 0;
+	summary->numThreads = numCounterSlots;
+	for (unsigned int k=0; k<numCounterSlots; k++) {
+		ThreadCounters current = counterSlots[k].counters;
+		uint64_t threadCompute = current.computeNs - previousCounters[k].computeNs;
+		compute += threadCompute;
+		wait += current.syncWaitNs - previousCounters[k].syncWaitNs;
+		sleep += current.sleepNs - previousCounters[k].sleepNs;
+		cells += current.cellsProcessed - previousCounters[k].cellsProcessed;
+		if (k < MAX_DISPLAYED_THREADS)
+			summary->utilization[k] = 1e-9 * threadCompute / wall;
+		previousCounters[k] = current;
+	}
+
+	uint64_t total = compute + wait + sleep;
+	summary->generation = generation;
+	summary->gensPerSec = (generation - previousGeneration) / wall;
+	summary->cellsPerSec = cells / wall;
+	summary->syncOverhead = total > 0 ? (double) wait / total : 0.0;
+	summary->sleepFraction = total > 0 ? (double) sleep / total : 0.0;
+
+	previousSampleTime = now;
+	previousGeneration = generation;
+}
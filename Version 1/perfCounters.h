@@ -0,0 +1,66 @@
+//
+//  perfCounters.h
+//  Cellular Automaton
+//
+//  Per-thread hot-path counters.  Each worker only ever writes its own
+//  slot, and every slot sits on its own cache line, so counting costs a few
+//  additions and clock reads per generation and no cache-line ping-pong.
+//
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+
+#define CACHE_LINE_SIZE		64
+//	number of threads shown individually in the state pane
+#define MAX_DISPLAYED_THREADS	24
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef struct ThreadCounters {
+	//	nanoseconds spent computing rows
+	uint64_t computeNs;
+	//	nanoseconds spent waiting at the generation barrier
+	uint64_t syncWaitNs;
+	//	nanoseconds spent waiting for the next generation's deadline
+	uint64_t sleepNs;
+	uint64_t cellsProcessed;
+	uint64_t generations;
+} ThreadCounters;
+
+typedef union PaddedCounters {
+	ThreadCounters counters;
+	char padding[CACHE_LINE_SIZE];
+} PaddedCounters;
+
+//	Rates computed from two samples of the counters
+typedef struct PerfSummary {
+	unsigned long generation;
+	double gensPerSec;
+	//	pace asked for (0 --> unlimited)
+	double targetGensPerSec;
+	double cellsPerSec;
+	//	fraction of all thread time spent waiting / sleeping
+	double syncOverhead;
+	double sleepFraction;
+	unsigned int numThreads;
+	//	fraction of wall time each thread spent computing
+	double utilization[MAX_DISPLAYED_THREADS];
+} PerfSummary;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void initializePerfCounters(unsigned int numThreads);
+ThreadCounters* threadCounters(unsigned int threadIndex);
+uint64_t perfNow(void);
+//	CPU time used by the calling thread (not counting time it was preempted)
+uint64_t perfThreadCPU(void);
+//	Updates the summary from the counters' change since the previous call
+void samplePerformance(PerfSummary* summary, unsigned long generation);
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,287 @@
+//
+//  poolAlloc.c
+//  Cellular Automaton
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "poolAlloc.h"
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+//	In front of every block (16 bytes, so that blocks stay 16-byte aligned)
+typedef struct BlockHeader {
+	//	size asked for, which gives the block's class
+	size_t requested;
+	//	next block of the free list the block is in
+	struct BlockHeader* next;
+} BlockHeader;
+
+typedef struct FreeList {
+	BlockHeader* first;
+	unsigned int count;
+} FreeList;
+
+//	A thread's free blocks & counters.  Only the thread that owns the cache
+//	writes to it; readPoolStats() reads the counters as they are.
+typedef struct PoolCache {
+	FreeList lists[POOL_NUM_CLASSES];
+	uint64_t allocations, frees, cacheHits;
+	uint64_t globalRefills, globalReleases;
+	uint64_t systemRuns, largeAllocations;
+	//	may go below 0 in the cache of a thread that frees others' blocks
+	int64_t requestedBytes;
+	//	0 --> the thread exited, the next new thread takes the cache over
+	int inUse;
+	struct PoolCache* nextCache;
+} PoolCache;
+
+typedef struct GlobalList {
+	pthread_mutex_t lock;
+	FreeList list;
+	//	runs of blocks taken from the system so far
+	unsigned int numRuns;
+} GlobalList;
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+GlobalList poolGlobalLists[POOL_NUM_CLASSES];
+pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+//	releases the free blocks of a thread that exits
+pthread_key_t poolCacheKey;
+
+//	all the caches ever created, in use or not
+PoolCache* poolCaches = NULL;
+pthread_mutex_t poolCacheLock = PTHREAD_MUTEX_INITIALIZER;
+__thread PoolCache* myPoolCache = NULL;
+
+atomic_uint_fast64_t poolReservedBytes = 0;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+//	Class of a block size: 0 for 64 B, then 4 classes per power of two
+//	(80, 96, 112, 128, 160, ...)
+unsigned int sizeClassOf(size_t size) {
+	if (size <= POOL_MIN_CLASS_SIZE)
+		return 0;
+	int power = 63 - __builtin_clzll(size - 1);
+	size_t base = (size_t) 1 << power;
+	//	(6: POOL_MIN_CLASS_SIZE is 2^6)
+	return (unsigned int) (power - 6)*4 + 1 + (unsigned int) ((size - 1 - base) / (base/4));
+}
+
+size_t classSize(unsigned int sizeClass) {
+	if (sizeClass == 0)
+		return POOL_MIN_CLASS_SIZE;
+	size_t base = (size_t) POOL_MIN_CLASS_SIZE << ((sizeClass - 1) / 4);
+	return base + ((sizeClass - 1) % 4 + 1)*(base/4);
+}
+
+//	free blocks of a class a thread keeps
+unsigned int cacheLimit(unsigned int sizeClass) {
+	unsigned int limit = (unsigned int) (POOL_CACHE_SIZE / classSize(sizeClass));
+	return limit < 4 ? 4 : limit;
+}
+
+//	Moves the first n blocks (1 to from->count) of a list to the front of another
+void moveBlocks(FreeList* from, FreeList* to, unsigned int n) {
+	BlockHeader* first = from->first;
+	BlockHeader* last = first;
+	for (unsigned int k=1; k<n; k++)
+		last = last->next;
+	from->first = last->next;
+	from->count -= n;
+	last->next = to->first;
+	to->first = first;
+	to->count += n;
+}
+
+//	pthread key destructor: the blocks of an exiting thread go to the global lists
+void releaseCache(void* data) {
+	PoolCache* cache = (PoolCache*) data;
+	for (unsigned int c=0; c<POOL_NUM_CLASSES; c++) {
+		FreeList* list = cache->lists + c;
+		if (list->count == 0)
+			continue;
+		cache->globalReleases += list->count;
+		pthread_mutex_lock(&poolGlobalLists[c].lock);
+		moveBlocks(list, &poolGlobalLists[c].list, list->count);
+		pthread_mutex_unlock(&poolGlobalLists[c].lock);
+	}
+	pthread_mutex_lock(&poolCacheLock);
+	cache->inUse = 0;
+	pthread_mutex_unlock(&poolCacheLock);
+}
+
+void initializePool(void) {
+	for (unsigned int c=0; c<POOL_NUM_CLASSES; c++)
+		pthread_mutex_init(&poolGlobalLists[c].lock, NULL);
+	pthread_key_create(&poolCacheKey, releaseCache);
+}
+
+//	First call of a thread: takes over the cache of an exited thread, or
+//	creates one (NULL if out of memory)
+PoolCache* claimCache(void) {
+	pthread_once(&poolOnce, initializePool);
+	pthread_mutex_lock(&poolCacheLock);
+	PoolCache* cache = poolCaches;
+	while (cache != NULL && cache->inUse)
+		cache = cache->nextCache;
+	if (cache == NULL) {
+		cache = (PoolCache*) calloc(1, sizeof(PoolCache));
+		if (cache != NULL) {
+			cache->nextCache = poolCaches;
+			poolCaches = cache;
+		}
+	}
+	if (cache != NULL)
+		cache->inUse = 1;
+	pthread_mutex_unlock(&poolCacheLock);
+
+	if (cache != NULL) {
+		pthread_setspecific(poolCacheKey, cache);
+		myPoolCache = cache;
+	}
+	return cache;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	The thread has no free block of the class left: it takes half a cache's
+ *	worth from the global list, which first gets a new run of blocks from
+ *	the system if it is empty too.  The runs of a class start at one block
+ *	and double up to POOL_RUN_SIZE, so that a class used for a single
+ *	buffer does not hold a whole run.  Returns 0 if out of memory.
+ *---------------------------------------------------------------------------
+ */
+int refillCache(PoolCache* cache, unsigned int sizeClass) {
+	GlobalList* global = poolGlobalLists + sizeClass;
+	unsigned int batch = cacheLimit(sizeClass) / 2;
+	pthread_mutex_lock(&global->lock);
+	if (global->list.count == 0) {
+		size_t blockSize = sizeof(BlockHeader) + classSize(sizeClass);
+		size_t numBlocks = POOL_RUN_SIZE / blockSize;
+		if (global->numRuns < 16 && numBlocks > ((size_t) 1 << global->numRuns))
+			numBlocks = (size_t) 1 << global->numRuns;
+		if (numBlocks == 0)
+			numBlocks = 1;
+		char* run = (char*) malloc(numBlocks*blockSize);
+		if (run == NULL) {
+			pthread_mutex_unlock(&global->lock);
+			return 0;
+		}
+		for (size_t k=0; k<numBlocks; k++) {
+			BlockHeader* block = (BlockHeader*) (run + k*blockSize);
+			block->next = global->list.first;
+			global->list.first = block;
+		}
+		global->list.count = (unsigned int) numBlocks;
+		global->numRuns++;
+		atomic_fetch_add(&poolReservedBytes, numBlocks*blockSize);
+		cache->systemRuns++;
+	}
+	unsigned int n = (global->list.count < batch) ? global->list.count : batch;
+	moveBlocks(&global->list, cache->lists + sizeClass, n);
+	pthread_mutex_unlock(&global->lock);
+	cache->globalRefills += n;
+	return 1;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void* poolAlloc(size_t size) {
+	PoolCache* cache = (myPoolCache != NULL) ? myPoolCache : claimCache();
+	if (cache == NULL)
+		return NULL;
+	BlockHeader* block;
+	if (size > POOL_MAX_CLASS_SIZE) {
+		block = (BlockHeader*) malloc(sizeof(BlockHeader) + size);
+		if (block == NULL)
+			return NULL;
+		atomic_fetch_add(&poolReservedBytes, sizeof(BlockHeader) + size);
+		cache->largeAllocations++;
+	} else {
+		unsigned int sizeClass = sizeClassOf(size);
+		FreeList* list = cache->lists + sizeClass;
+		if (list->first != NULL)
+			cache->cacheHits++;
+		else if (!refillCache(cache, sizeClass))
+			return NULL;
+		block = list->first;
+		list->first = block->next;
+		list->count--;
+	}
+	block->requested = size;
+	cache->allocations++;
+	cache->requestedBytes += size;
+	return block + 1;
+}
+
+void poolFree(void* data) {
+	if (data == NULL)
+		return;
+	PoolCache* cache = (myPoolCache != NULL) ? myPoolCache : claimCache();
+	BlockHeader* block = (BlockHeader*) data - 1;
+	size_t size = block->requested;
+	if (size > POOL_MAX_CLASS_SIZE || cache == NULL) {
+		//	(a class block is only given back to the system without a cache
+		//	to put it in, which never happens short of running out of memory)
+		if (size > POOL_MAX_CLASS_SIZE) {
+			atomic_fetch_sub(&poolReservedBytes, sizeof(BlockHeader) + size);
+			free(block);
+		}
+		if (cache != NULL) {
+			cache->frees++;
+			cache->requestedBytes -= size;
+		}
+		return;
+	}
+	unsigned int sizeClass = sizeClassOf(size);
+	FreeList* list = cache->lists + sizeClass;
+	block->next = list->first;
+	list->first = block;
+	list->count++;
+	cache->frees++;
+	cache->requestedBytes -= size;
+
+	if (list->count > cacheLimit(sizeClass)) {
+		unsigned int n = list->count / 2;
+		pthread_mutex_lock(&poolGlobalLists[sizeClass].lock);
+		moveBlocks(list, &poolGlobalLists[sizeClass].list, n);
+		pthread_mutex_unlock(&poolGlobalLists[sizeClass].lock);
+		cache->globalReleases += n;
+	}
+}
+
+void readPoolStats(PoolStats* stats) {
+	memset(stats, 0, sizeof(PoolStats));
+	int64_t requested = 0;
+	pthread_mutex_lock(&poolCacheLock);
+	for (const PoolCache* cache=poolCaches; cache!=NULL; cache=cache->nextCache) {
+		stats->allocations += cache->allocations;
+		stats->frees += cache->frees;
+		stats->cacheHits += cache->cacheHits;
+		stats->globalRefills += cache->globalRefills;
+		stats->globalReleases += cache->globalReleases;
+		stats->systemRuns += cache->systemRuns;
+		stats->largeAllocations += cache->largeAllocations;
+		requested += cache->requestedBytes;
+	}
+	pthread_mutex_unlock(&poolCacheLock);
+	stats->requestedBytes = (requested > 0) ? (uint64_t) requested : 0;
+	stats->reservedBytes = atomic_load(&poolReservedBytes);
+	if (stats->allocations > 0)
+		stats->hitRate = (double) stats->cacheHits / stats->allocations;
+	if (stats->reservedBytes > 0 && stats->requestedBytes <= stats->reservedBytes)
+		stats->fragmentation = 1.0 - (double) stats->requestedBytes / stats->reservedBytes;
+}
@@ -0,0 +1,65 @@
+//
+//  poolAlloc.h
+//  Cellular Automaton
+//
+//  Size-class allocator for the simulation's chunks & buffers.  Sizes are
+//  rounded up to one of 4 classes per power of two; each thread keeps its
+//  own free blocks of every class, so that most allocations and frees take
+//  no lock.  A thread holding too many free blocks of a class moves half of
+//  them to the global list of the class, where threads that run out take
+//  them back from.  Only when the global list is empty too does the pool
+//  call malloc(), for a run of blocks.  Blocks are never given back to the
+//  system: once a simulation has reached its largest size, its generations
+//  allocate nothing from it.
+//
+//  Blocks larger than the largest class go straight to malloc() & free().
+//
+
+#ifndef POOL_ALLOC_H
+#define POOL_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define POOL_MIN_CLASS_SIZE		64
+#define POOL_MAX_CLASS_SIZE		(256*1024)
+//	4 classes per power of two from 64 B to 256 KB
+#define POOL_NUM_CLASSES		49
+//	most bytes taken from the system at once when a class runs out of blocks
+#define POOL_RUN_SIZE			(64*1024)
+//	bytes of free blocks of a class a thread keeps before giving half away
+#define POOL_CACHE_SIZE			(256*1024)
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+//	Counters of all the threads, added up
+typedef struct PoolStats {
+	uint64_t allocations, frees;
+	//	allocations served by the thread's own free blocks
+	uint64_t cacheHits;
+	//	blocks taken from / given to the global lists
+	uint64_t globalRefills, globalReleases;
+	//	calls to malloc(): runs of blocks, and blocks larger than the classes
+	uint64_t systemRuns, largeAllocations;
+	//	bytes asked for by the blocks in use, and bytes taken from the system
+	uint64_t requestedBytes, reservedBytes;
+	//	cacheHits / allocations
+	double hitRate;
+	//	share of the reserved bytes not holding requested ones (rounding up
+	//	to the classes, and free blocks)
+	double fragmentation;
+} PoolStats;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	NULL if out of memory
+void* poolAlloc(size_t size);
+//	Any thread may free a block, not only the one that allocated it
+void poolFree(void* block);
+void readPoolStats(PoolStats* stats);
+
+#endif // POOL_ALLOC_H
@@ -0,0 +1,123 @@
+//
+//  processLauncher.c
+//  Cellular Automaton
+//
+//  The processes are forked, so they inherit the parsed options and the
+//  transport's setup.  Each one writes its result in a pipe to the launcher
+//  when it exits (one write of less than PIPE_BUF bytes, so never mixed up).
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "processLauncher.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+//	write end of the result pipe, in the processes
+int resultPipe = -1;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+void killProcesses(pid_t* pids, int numProcesses) {
+	for (int k=0; k<numProcesses; k++) {
+		if (pids[k] > 0)
+			kill(pids[k], SIGTERM);
+	}
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	If a process fails, its neighbors would wait for its halo rows forever:
+ *	take everybody down.
+ *---------------------------------------------------------------------------
+ */
+int waitForProcesses(pid_t* pids, int numProcesses) {
+	int failed = 0;
+	for (int remaining=numProcesses; remaining>0; remaining--) {
+		int status;
+		pid_t pid = wait(&status);
+		if (pid < 0)
+			break;
+		for (int k=0; k<numProcesses; k++) {
+			if (pids[k] == pid)
+				pids[k] = 0;
+		}
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			if (!failed)
+				killProcesses(pids, numProcesses);
+			failed = 1;
+		}
+	}
+	return !failed;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int launchProcesses(int numProcesses, const HaloTransport* transport, int rowLength, int periodic) {
+	int fds[2];
+	if (!transport->create(numProcesses, rowLength) || pipe(fds) != 0) {
+		fprintf(stderr, "could not set up the %s transport\n", transport->name);
+		exit(-1);
+	}
+
+	pid_t* pids = (pid_t*) calloc(numProcesses, sizeof(pid_t));
+	for (int rank=0; rank<numProcesses; rank++) {
+		pid_t pid = fork();
+		if (pid == 0) {
+			close(fds[0]);
+			resultPipe = fds[1];
+			free(pids);
+			if (!transport->attach(rank, numProcesses, rowLength, periodic)) {
+				fprintf(stderr, "process %d could not attach to the %s transport\n", rank, transport->name);
+				_exit(-1);
+			}
+			return rank;
+		}
+		if (pid < 0) {
+			fprintf(stderr, "could not start process %d\n", rank);
+			killProcesses(pids, rank);
+			transport->destroy();
+			exit(-1);
+		}
+		pids[rank] = pid;
+	}
+
+	close(fds[1]);
+	int ok = waitForProcesses(pids, numProcesses);
+	transport->destroy();
+
+	ProcessResult result, total = {-1, 0, 0, 0};
+	int numResults = 0;
+	while (read(fds[0], &result, sizeof(ProcessResult)) == sizeof(ProcessResult)) {
+		total.generation = result.generation;
+		total.population += result.population;
+		total.hash += result.hash;
+		numResults++;
+	}
+	if (!ok || numResults != numProcesses) {
+		fprintf(stderr, "%d of %d processes completed\n", numResults, numProcesses);
+		exit(-1);
+	}
+	fprintf(stderr, "generation %lu: population %lu, hash %016llx (%d processes)\n",
+			total.generation, total.population, (unsigned long long) total.hash, numProcesses);
+	exit(0);
+}
+
+void rankRows(int rank, int numProcesses, int numRows, int* startRow, int* endRow) {
+	*startRow = (int) ((long) numRows * rank / numProcesses);
+	*endRow = (int) ((long) numRows * (rank+1) / numProcesses);
+}
+
+void reportProcessResult(const ProcessResult* result) {
+	if (resultPipe >= 0 && write(resultPipe, result, sizeof(ProcessResult)) != sizeof(ProcessResult))
+		fprintf(stderr, "process %d could not report its result\n", result->rank);
+}
@@ -0,0 +1,43 @@
+//
+//  processLauncher.h
+//  Cellular Automaton
+//
+//  Splits the grid into bands of rows and runs each band in its own
+//  process (each with its own worker threads), the bands' edges being
+//  exchanged through a halo transport.  The launching process only waits
+//  for the others and adds up their results.
+//
+
+#ifndef PROCESS_LAUNCHER_H
+#define PROCESS_LAUNCHER_H
+
+#include <stdint.h>
+#include "haloTransport.h"
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+//	what each process reports to the launcher when it exits
+typedef struct ProcessResult {
+	int rank;
+	unsigned long generation;
+	unsigned long population;
+	uint64_t hash;
+} ProcessResult;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	Starts numProcesses processes and returns the rank of the band it owns in
+//	each of them.  Never returns in the launcher: it waits for the processes,
+//	prints the combined result and exits.  rowLength is the number of ints
+//	in the rows exchanged; a periodic grid wraps from the last band to the first.
+int launchProcesses(int numProcesses, const HaloTransport* transport, int rowLength, int periodic);
+//	Rows [*startRow, *endRow) of the whole grid are owned by the given rank
+void rankRows(int rank, int numProcesses, int numRows, int* startRow, int* endRow);
+//	Sends this process' result to the launcher
+void reportProcessResult(const ProcessResult* result);
+
+#endif // PROCESS_LAUNCHER_H
@@ -0,0 +1,160 @@
+//
+//  shmTransport.c
+//  Cellular Automaton
+//
+//  Halo exchange through a POSIX shared memory segment.  Each process has
+//  two copies (even & odd generations) of its first and last rows in the
+//  segment, and a sequence word telling which generation they hold.  A
+//  process that needs a neighbor's rows sleeps on that word with a futex.
+//
+//  Two copies are enough: a neighbor can only publish generation g+2 (in
+//  the buffer of g) after receiving our rows of g+1, which we publish after
+//  copying its rows of g.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "haloTransport.h"
+
+//---------------------------------------------------------------------------
+//  Private data types
+//---------------------------------------------------------------------------
+
+typedef struct RankHeader {
+	//	generation+1 of the rows published by the process (0 --> none yet)
+	_Alignas(64) atomic_uint published;
+} RankHeader;
+
+enum {EDGE_FIRST = 0, EDGE_LAST = 1};
+
+//---------------------------------------------------------------------------
+//  Function prototypes
+//---------------------------------------------------------------------------
+
+int shmCreate(int numRanks, int rowLength);
+void shmDestroy(void);
+int shmAttach(int rank, int numRanks, int rowLength, int periodic);
+void shmExchange(const int* firstRow, const int* lastRow,
+				 int* haloAbove, int* haloBelow, unsigned long generation);
+void shmDetach(void);
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+const HaloTransport SHM_TRANSPORT = {"shm", shmCreate, shmDestroy, shmAttach, shmExchange, shmDetach};
+
+//	name of the segment (set by the launcher, inherited by the processes)
+char segmentName[64] = "";
+size_t segmentSize = 0;
+
+void* segment = NULL;
+RankHeader* headers = NULL;
+int* edgeRows = NULL;
+int shmRank = 0;
+int shmNumRanks = 0;
+int shmRowLength = 0;
+int shmPeriodic = 0;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+size_t layoutSize(int numRanks, int rowLength) {
+	return numRanks * sizeof(RankHeader) + (size_t) numRanks * 4 * rowLength * sizeof(int);
+}
+
+int* edgeRow(int rank, unsigned long generation, int edge) {
+	return edgeRows + ((size_t) (rank*2 + (generation & 1)) * 2 + edge) * shmRowLength;
+}
+
+//	not FUTEX_PRIVATE: the word is shared between processes
+void futexWait(atomic_uint* word, unsigned int value) {
+	syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+void futexWake(atomic_uint* word) {
+	syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+void waitForRank(int rank, unsigned int sequence) {
+	atomic_uint* word = &headers[rank].published;
+	unsigned int value;
+	while ((int) ((value = atomic_load_explicit(word, memory_order_acquire)) - sequence) < 0)
+		futexWait(word, value);
+}
+
+//---------------------------------------------------------------------------
+//	Transport functions
+//---------------------------------------------------------------------------
+
+int shmCreate(int numRanks, int rowLength) {
+	snprintf(segmentName, sizeof(segmentName), "/cellHalo.%d", (int) getpid());
+	segmentSize = layoutSize(numRanks, rowLength);
+	int fd = shm_open(segmentName, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+		return 0;
+	//	a new segment is filled with zeros: nothing published yet
+	int ok = (ftruncate(fd, segmentSize) == 0);
+	close(fd);
+	return ok;
+}
+
+void shmDestroy(void) {
+	shm_unlink(segmentName);
+}
+
+int shmAttach(int rank, int numRanks, int rowLength, int periodic) {
+	int fd = shm_open(segmentName, O_RDWR, 0600);
+	if (fd < 0)
+		return 0;
+	segment = mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED) {
+		segment = NULL;
+		return 0;
+	}
+	shmRank = rank;
+	shmNumRanks = numRanks;
+	shmRowLength = rowLength;
+	shmPeriodic = periodic;
+	headers = (RankHeader*) segment;
+	edgeRows = (int*) (headers + numRanks);
+	return 1;
+}
+
+void shmExchange(const int* firstRow, const int* lastRow,
+				 int* haloAbove, int* haloBelow, unsigned long generation) {
+	size_t rowBytes = shmRowLength * sizeof(int);
+	unsigned int sequence = (unsigned int) (generation + 1);
+
+	memcpy(edgeRow(shmRank, generation, EDGE_FIRST), firstRow, rowBytes);
+	memcpy(edgeRow(shmRank, generation, EDGE_LAST), lastRow, rowBytes);
+	atomic_store_explicit(&headers[shmRank].published, sequence, memory_order_release);
+	futexWake(&headers[shmRank].published);
+
+	if (shmRank > 0 || shmPeriodic) {
+		int above = (shmRank + shmNumRanks - 1) % shmNumRanks;
+		waitForRank(above, sequence);
+		memcpy(haloAbove, edgeRow(above, generation, EDGE_LAST), rowBytes);
+	}
+	if (shmRank < shmNumRanks-1 || shmPeriodic) {
+		int below = (shmRank + 1) % shmNumRanks;
+		waitForRank(below, sequence);
+		memcpy(haloBelow, edgeRow(below, generation, EDGE_FIRST), rowBytes);
+	}
+}
+
+void shmDetach(void) {
+	if (segment != NULL) {
+		munmap(segment, segmentSize);
+		segment = NULL;
+	}
+}
@@ -0,0 +1,338 @@
+//
+//  sparsePlane.c
+//  Cellular Automaton
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "sparsePlane.h"
+#include "poolAlloc.h"
+
+//	a chunk that is not in the table: all dead
+static const Chunk EMPTY_CHUNK;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+//	chunk holding a row or column (rounded down for negative ones)
+int32_t chunkOf(long cell) {
+	return (int32_t) (cell >= 0 ? cell / CHUNK_SIZE : -((-cell + CHUNK_SIZE - 1) / CHUNK_SIZE));
+}
+
+unsigned int tableSlot(const SparsePlane* plane, int32_t x, int32_t y) {
+	uint64_t key = ((uint64_t) (uint32_t) x << 32) | (uint32_t) y;
+	return (unsigned int) mixHash(key) & (plane->tableSize - 1);
+}
+
+Chunk* findChunk(const SparsePlane* plane, int32_t x, int32_t y) {
+	for (unsigned int slot=tableSlot(plane, x, y); plane->table[slot] != NULL;
+		 slot = (slot + 1) & (plane->tableSize - 1)) {
+		Chunk* chunk = plane->table[slot];
+		if (chunk->x == x && chunk->y == y)
+			return chunk;
+	}
+	return NULL;
+}
+
+void insertChunk(SparsePlane* plane, Chunk* chunk) {
+	unsigned int slot = tableSlot(plane, chunk->x, chunk->y);
+	while (plane->table[slot] != NULL)
+		slot = (slot + 1) & (plane->tableSize - 1);
+	plane->table[slot] = chunk;
+}
+
+//	Empties the table and puts the chunks of the list back in it (growing
+//	it first if it would be more than half full)
+void rebuildTable(SparsePlane* plane) {
+	if (2*(unsigned int) plane->maxChunks > plane->tableSize) {
+		while (2*(unsigned int) plane->maxChunks > plane->tableSize)
+			plane->tableSize *= 2;
+		free(plane->table);
+		plane->table = (Chunk**) malloc(plane->tableSize*sizeof(Chunk*));
+	}
+	memset(plane->table, 0, plane->tableSize*sizeof(Chunk*));
+	for (int k=0; k<plane->numChunks; k++)
+		insertChunk(plane, plane->chunks[k]);
+}
+
+//	A new dead chunk, in the list & the table: a spare one if there is
+//	one, else from the pool
+Chunk* addChunk(SparsePlane* plane, int32_t x, int32_t y) {
+	Chunk* chunk = plane->spareChunks;
+	if (chunk != NULL)
+		plane->spareChunks = chunk->nextSpare;
+	else
+		chunk = (Chunk*) poolAlloc(sizeof(Chunk));
+	memset(chunk->rows, 0, sizeof(chunk->rows));
+	chunk->x = x;
+	chunk->y = y;
+	chunk->needed = 1;
+
+	if (plane->numChunks == plane->maxChunks) {
+		plane->maxChunks *= 2;
+		plane->chunks = (Chunk**) realloc(plane->chunks, plane->maxChunks*sizeof(Chunk*));
+		rebuildTable(plane);
+	}
+	plane->chunks[plane->numChunks++] = chunk;
+	insertChunk(plane, chunk);
+	return chunk;
+}
+
+Chunk* findOrAddChunk(SparsePlane* plane, int32_t x, int32_t y) {
+	Chunk* chunk = findChunk(plane, x, y);
+	return chunk != NULL ? chunk : addChunk(plane, x, y);
+}
+
+const Chunk* chunkOrEmpty(const SparsePlane* plane, int32_t x, int32_t y) {
+	const Chunk* chunk = findChunk(plane, x, y);
+	return chunk != NULL ? chunk : &EMPTY_CHUNK;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	The next generation of one chunk.  Its rows & the ones of the chunks
+ *	around it are first gathered in 3 columns of 66 words (the chunk's
+ *	rows, with the neighbors' edge rows above & below), so that the loop
+ *	never tests for a chunk edge.
+ *---------------------------------------------------------------------------
+ */
+void stepChunk(const SparsePlane* plane, Chunk* chunk, GenerationStats* stats) {
+	int cur = plane->current;
+	uint64_t column[3][CHUNK_SIZE + 2];
+	for (int dx=-1; dx<=1; dx++) {
+		uint64_t* words = column[dx+1];
+		const Chunk* above = chunkOrEmpty(plane, chunk->x + dx, chunk->y - 1);
+		const Chunk* beside = (dx == 0) ? chunk : chunkOrEmpty(plane, chunk->x + dx, chunk->y);
+		const Chunk* below = chunkOrEmpty(plane, chunk->x + dx, chunk->y + 1);
+		words[0] = above->rows[cur][CHUNK_SIZE-1];
+		memcpy(words + 1, beside->rows[cur], CHUNK_SIZE*sizeof(uint64_t));
+		words[CHUNK_SIZE+1] = below->rows[cur][0];
+	}
+
+	const LifeRule rule = plane->rule;
+	uint16_t counts = rule.birth | rule.survival;
+	const uint64_t* west = column[0];
+	const uint64_t* mid = column[1];
+	const uint64_t* east = column[2];
+	unsigned long population = 0, births = 0, deaths = 0;
+	uint64_t hash = 0;
+	for (int r=1; r<=CHUNK_SIZE; r++) {
+		//	bit j of a shifted word: the cell west (j-1) or east (j+1) of cell j
+		uint64_t nb[8], n[4];
+		nb[7] = (mid[r-1] << 1) | (west[r-1] >> 63);
+		nb[6] = mid[r-1];
+		nb[5] = (mid[r-1] >> 1) | (east[r-1] << 63);
+		nb[4] = (mid[r] << 1) | (west[r] >> 63);
+		nb[3] = (mid[r] >> 1) | (east[r] << 63);
+		nb[2] = (mid[r+1] << 1) | (west[r+1] >> 63);
+		nb[1] = mid[r+1];
+		nb[0] = (mid[r+1] >> 1) | (east[r+1] << 63);
+		mooreCounts(nb, n);
+
+		uint64_t born = 0, survive = 0;
+		for (int k=0; k<=8; k++) {
+			if (!(counts & (1 << k)))
+				continue;
+			uint64_t is = countIs(n, k);
+			if (rule.birth & (1 << k))
+				born |= is;
+			if (rule.survival & (1 << k))
+				survive |= is;
+		}
+		uint64_t alive = mid[r];
+		uint64_t next = (born & ~alive) | (survive & alive);
+		chunk->rows[cur ^ 1][r-1] = next;
+		population += __builtin_popcountll(next);
+		births += __builtin_popcountll(next & ~alive);
+		deaths += __builtin_popcountll(alive & ~next);
+		//	one hash per non-empty row of 64 cells, so that the empty chunks
+		//	that come & go don't change it
+		if (next != 0) {
+			uint64_t where = ((uint64_t) (uint32_t) chunk->x << 32) |
+							 (uint32_t) ((int64_t) chunk->y * CHUNK_SIZE + r - 1);
+			hash += mixHash(next ^ mixHash(where));
+		}
+	}
+	stats->stateCount[1] += population;
+	stats->births += births;
+	stats->deaths += deaths;
+	stats->hash += hash;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int planeRuleFits(const LifeRule* rule) {
+	return rule->states == 2 && rule->neighborhood == NEIGHBORHOOD_MOORE &&
+		   !rule->isotropic && !(rule->birth & 1);
+}
+
+void createPlane(SparsePlane* plane, LifeRule rule) {
+	memset(plane, 0, sizeof(SparsePlane));
+	plane->rule = rule;
+	plane->maxChunks = 64;
+	plane->chunks = (Chunk**) malloc(plane->maxChunks*sizeof(Chunk*));
+	plane->tableSize = 128;
+	plane->table = (Chunk**) calloc(plane->tableSize, sizeof(Chunk*));
+	plane->minRow = plane->minCol = 0;
+	plane->maxRow = plane->maxCol = -1;
+}
+
+void destroyPlane(SparsePlane* plane) {
+	for (int k=0; k<plane->numChunks; k++)
+		poolFree(plane->chunks[k]);
+	while (plane->spareChunks != NULL) {
+		Chunk* chunk = plane->spareChunks;
+		plane->spareChunks = chunk->nextSpare;
+		poolFree(chunk);
+	}
+	free(plane->chunks);
+	free(plane->table);
+	memset(plane, 0, sizeof(SparsePlane));
+}
+
+void setPlaneRule(SparsePlane* plane, LifeRule rule) {
+	plane->rule = rule;
+}
+
+void clearPlane(SparsePlane* plane) {
+	for (int k=0; k<plane->numChunks; k++) {
+		plane->chunks[k]->nextSpare = plane->spareChunks;
+		plane->spareChunks = plane->chunks[k];
+	}
+	plane->numChunks = 0;
+	memset(plane->table, 0, plane->tableSize*sizeof(Chunk*));
+	plane->minRow = plane->minCol = 0;
+	plane->maxRow = plane->maxCol = -1;
+}
+
+void setPlaneCell(SparsePlane* plane, long row, long col, int alive) {
+	int32_t x = chunkOf(col), y = chunkOf(row);
+	Chunk* chunk = alive ? findOrAddChunk(plane, x, y) : findChunk(plane, x, y);
+	if (chunk == NULL)
+		return;
+	uint64_t* word = &chunk->rows[plane->current][row - (long) y*CHUNK_SIZE];
+	uint64_t bit = 1ull << (col - (long) x*CHUNK_SIZE);
+	*word = alive ? (*word | bit) : (*word & ~bit);
+}
+
+int planeCell(const SparsePlane* plane, long row, long col) {
+	int32_t x = chunkOf(col), y = chunkOf(row);
+	const Chunk* chunk = chunkOrEmpty(plane, x, y);
+	return (chunk->rows[plane->current][row - (long) y*CHUNK_SIZE] >> (col - (long) x*CHUNK_SIZE)) & 1;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	A chunk is kept if it has live cells, or if a chunk next to it has live
+ *	cells along their common edge (or corner): only there can cells be born
+ *	in the next generation.  The others go back to the pool.
+ *---------------------------------------------------------------------------
+ */
+void tidyPlane(SparsePlane* plane) {
+	int cur = plane->current;
+	for (int k=0; k<plane->numChunks; k++)
+		plane->chunks[k]->needed = 0;
+	plane->minRow = plane->minCol = 0;
+	plane->maxRow = plane->maxCol = -1;
+	int first = 1;
+
+	//	(chunks added on the way are dead: no need to look at them)
+	int numChunks = plane->numChunks;
+	for (int k=0; k<numChunks; k++) {
+		Chunk* chunk = plane->chunks[k];
+		const uint64_t* rows = chunk->rows[cur];
+		uint64_t any = 0, westEdge = 0, eastEdge = 0;
+		int top = -1, bottom = -1;
+		for (int r=0; r<CHUNK_SIZE; r++) {
+			if (rows[r] != 0) {
+				if (top < 0)
+					top = r;
+				bottom = r;
+			}
+			any |= rows[r];
+			westEdge |= rows[r] & 1;
+			eastEdge |= rows[r] >> 63;
+		}
+		if (any == 0)
+			continue;
+		chunk->needed = 1;
+
+		long left = (long) chunk->x*CHUNK_SIZE + __builtin_ctzll(any);
+		long right = (long) chunk->x*CHUNK_SIZE + 63 - __builtin_clzll(any);
+		if (first || left < plane->minCol)
+			plane->minCol = left;
+		if (first || right > plane->maxCol)
+			plane->maxCol = right;
+		if (first || (long) chunk->y*CHUNK_SIZE + top < plane->minRow)
+			plane->minRow = (long) chunk->y*CHUNK_SIZE + top;
+		if (first || (long) chunk->y*CHUNK_SIZE + bottom > plane->maxRow)
+			plane->maxRow = (long) chunk->y*CHUNK_SIZE + bottom;
+		first = 0;
+
+		//	edges: north, south, west, east, then the 4 corners
+		int north = rows[0] != 0, south = rows[CHUNK_SIZE-1] != 0;
+		int touches[8][3] = {
+			{0, -1, north}, {0, 1, south}, {-1, 0, westEdge != 0}, {1, 0, eastEdge != 0},
+			{-1, -1, (int) (rows[0] & 1)}, {1, -1, (int) (rows[0] >> 63)},
+			{-1, 1, (int) (rows[CHUNK_SIZE-1] & 1)}, {1, 1, (int) (rows[CHUNK_SIZE-1] >> 63)}
+		};
+		for (int d=0; d<8; d++) {
+			if (touches[d][2])
+				findOrAddChunk(plane, chunk->x + touches[d][0], chunk->y + touches[d][1])->needed = 1;
+		}
+	}
+
+	int kept = 0;
+	for (int k=0; k<plane->numChunks; k++) {
+		Chunk* chunk = plane->chunks[k];
+		if (chunk->needed) {
+			plane->chunks[kept++] = chunk;
+		} else {
+			chunk->nextSpare = plane->spareChunks;
+			plane->spareChunks = chunk;
+		}
+	}
+	if (kept < plane->numChunks) {
+		plane->numChunks = kept;
+		rebuildTable(plane);
+	}
+}
+
+void stepPlaneChunks(SparsePlane* plane, int first, int end, GenerationStats* stats) {
+	for (int k=first; k<end; k++)
+		stepChunk(plane, plane->chunks[k], stats);
+}
+
+void advancePlane(SparsePlane* plane) {
+	plane->current ^= 1;
+	tidyPlane(plane);
+}
+
+void copyPlaneWindow(const SparsePlane* plane, long row, long col, const Grid* grid) {
+	int cur = plane->current;
+	for (int i=0; i<grid->numRows; i++) {
+		long planeRow = row + i;
+		int32_t y = chunkOf(planeRow);
+		int r = (int) (planeRow - (long) y*CHUNK_SIZE);
+		for (int b=0; b<grid->numBands; b++) {
+			int* cells = grid->band[b][i];
+			//	one chunk lookup per 64 cells (or fewer, at the band's edges)
+			int j = grid->firstCol[b];
+			while (j < grid->firstCol[b+1]) {
+				long planeCol = col + j;
+				int32_t x = chunkOf(planeCol);
+				int c = (int) (planeCol - (long) x*CHUNK_SIZE);
+				int length = CHUNK_SIZE - c;
+				if (length > grid->firstCol[b+1] - j)
+					length = grid->firstCol[b+1] - j;
+				uint64_t word = chunkOrEmpty(plane, x, y)->rows[cur][r] >> c;
+				for (int t=0; t<length; t++)
+					cells[j + t] = (word >> t) & 1;
+				j += length;
+			}
+		}
+	}
+}
@@ -0,0 +1,93 @@
+//
+//  sparsePlane.h
+//  Cellular Automaton
+//
+//  Unbounded plane for two-state B/S rules on the 8 neighbors.  Only the
+//  64 x 64 chunks that hold live cells, or that may get births in the next
+//  generation, exist: they are found by their chunk coordinates in a hash
+//  table, taken from the pool allocator when a pattern grows into them and
+//  kept as spares once they are empty.  A chunk's rows are 64-bit words
+//  (bit j: column j), computed 64 cells at a time with the batch engine's
+//  adders.
+//
+//  The threads each step a share of the chunks, reading the table but not
+//  changing it; chunks are only added & removed between two generations.
+//  That is done by whichever thread completes the generation, so empty
+//  chunks stay with the plane rather than in that thread's pool cache,
+//  where the next thread to complete one could not reuse them: a plane
+//  that stopped growing allocates nothing.
+//
+
+#ifndef SPARSE_PLANE_H
+#define SPARSE_PLANE_H
+
+#include <stdint.h>
+#include "lifeEngine.h"
+#include "genStats.h"
+#include "gridLayout.h"
+
+#define CHUNK_SIZE			64
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef struct Chunk {
+	//	columns x*64 to x*64+63, rows y*64 to y*64+63
+	int32_t x, y;
+	//	the rows of the two generations (the plane says which is the current one)
+	uint64_t rows[2][CHUNK_SIZE];
+	//	1 --> kept for the next generation
+	int needed;
+	//	next spare chunk, while the chunk is not in use
+	struct Chunk* nextSpare;
+} Chunk;
+
+typedef struct SparsePlane {
+	LifeRule rule;
+	//	which rows of the chunks are the current generation (0 or 1)
+	int current;
+	Chunk** chunks;
+	int numChunks, maxChunks;
+	//	empty chunks, to be reused before asking the pool for new ones
+	Chunk* spareChunks;
+	//	open addressing on the chunk coordinates, at most half full
+	Chunk** table;
+	unsigned int tableSize;
+	//	bounding box of the live cells, updated between generations
+	//	(empty when minRow > maxRow)
+	long minRow, maxRow, minCol, maxCol;
+} SparsePlane;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	1 if the plane can run the rule: two states, 8 neighbors, totalistic, no
+//	birth with 0 neighbors (which would fill the whole plane)
+int planeRuleFits(const LifeRule* rule);
+void createPlane(SparsePlane* plane, LifeRule rule);
+void destroyPlane(SparsePlane* plane);
+void setPlaneRule(SparsePlane* plane, LifeRule rule);
+//	All the chunks go back to the pool
+void clearPlane(SparsePlane* plane);
+
+//	Cells, between two generations (rows grow downward, columns eastward)
+void setPlaneCell(SparsePlane* plane, long row, long col, int alive);
+int planeCell(const SparsePlane* plane, long row, long col);
+//	After cells were set: creates the chunks next to live edges, frees the
+//	empty ones and updates the bounding box
+void tidyPlane(SparsePlane* plane);
+
+//	Computes the next generation of chunks first to end-1, adding their
+//	counts & hash to stats; threads may call it at the same time on
+//	different chunks
+void stepPlaneChunks(SparsePlane* plane, int first, int end, GenerationStats* stats);
+//	Once all chunks are stepped: makes the next generation the current one
+void advancePlane(SparsePlane* plane);
+
+//	Copies the cells of the grid-sized window whose top-left cell is
+//	(row, col) into the grid (1 for live cells)
+void copyPlaneWindow(const SparsePlane* plane, long row, long col, const Grid* grid);
+
+#endif // SPARSE_PLANE_H
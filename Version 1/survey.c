@@ -0,0 +1,225 @@
+//
+//  survey.c
+//  Cellular Automaton
+//
+//  Each worker owns one engine and reuses it for all its runs, so the
+//  survey allocates nothing once started.  Rules are handed out from a
+//  shared counter; the ones already in the results file are skipped.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "survey.h"
+#include "lifeEngine.h"
+#include "perfCounters.h"
+
+//---------------------------------------------------------------------------
+//  Private data types
+//---------------------------------------------------------------------------
+
+typedef struct RuleSummary {
+	double meanPopulation;
+	double density;
+	//	population at the end / at half of the run
+	double growth;
+	//	fraction of the cells that changed in the last generation
+	double activity;
+	int periodicSeeds;
+	int deadSeeds;
+	unsigned int maxPeriod;
+	const char* behavior;
+} RuleSummary;
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+int surveySeeds = 4;
+unsigned long surveyGenerations = 500;
+int surveySize = 64;
+Boundary surveyBoundary = BOUNDARY_WRAP;
+
+//	rules already in the results file
+unsigned char* ruleDone = NULL;
+atomic_int nextRule = 0;
+atomic_int rulesSurveyed = 0;
+
+FILE* surveyCSV = NULL;
+pthread_mutex_t surveyLock = PTHREAD_MUTEX_INITIALIZER;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+LifeRule ruleFromNumber(int number) {
+	LifeRule rule = {.birth = number & 0x1FF, .survival = (number >> 9) & 0x1FF,
+					 .states = 2, .neighborhood = NEIGHBORHOOD_MOORE};
+	return rule;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Marks the rules found in the results file.  Only complete lines count:
+ *	a line cut short when the survey was interrupted is surveyed again.
+ *	Returns 0 if the file is not a results file.
+ *---------------------------------------------------------------------------
+ */
+int readDoneRules(const char* path, int* endsWithNewline) {
+	FILE* file = fopen(path, "r");
+	*endsWithNewline = 1;
+	if (file == NULL)
+		return 1;
+	char line[256];
+	int number, lineNumber = 0, ok = 1;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		size_t length = strlen(line);
+		*endsWithNewline = (length > 0 && line[length-1] == '\n');
+		if (lineNumber++ == 0) {
+			ok = (strncmp(line, "rule,", 5) == 0);
+			if (!ok)
+				break;
+		}
+		else if (*endsWithNewline && sscanf(line, "%d,", &number) == 1 &&
+				 number >= 0 && number < NUM_LIFE_RULES)
+			ruleDone[number] = 1;
+	}
+	fclose(file);
+	return ok;
+}
+
+void surveyRule(LifeEngine* engine, int number, RuleSummary* summary) {
+	LifeRule rule = ruleFromNumber(number);
+	double cells = (double) surveySize * surveySize;
+	unsigned long halfPopulation = 0, population = 0, changes = 0;
+	memset(summary, 0, sizeof(RuleSummary));
+
+	for (int seed=0; seed<surveySeeds; seed++) {
+		startEngine(engine, surveySize, surveySize, rule, surveyBoundary, (uint64_t) seed);
+		engineRun(engine, surveyGenerations / 2);
+		halfPopulation += engine->population;
+		engineRun(engine, surveyGenerations);
+		population += engine->population;
+		changes += engine->births + engine->deaths;
+
+		if (engine->population == 0)
+			summary->deadSeeds++;
+		if (engine->period > 0) {
+			summary->periodicSeeds++;
+			if (engine->period > summary->maxPeriod)
+				summary->maxPeriod = engine->period;
+		}
+	}
+
+	summary->meanPopulation = (double) population / surveySeeds;
+	summary->density = summary->meanPopulation / cells;
+	summary->growth = halfPopulation > 0 ? (double) population / halfPopulation : 0.0;
+	summary->activity = changes / (cells * surveySeeds);
+
+	if (summary->deadSeeds == surveySeeds)
+		summary->behavior = "dies";
+	else if (summary->periodicSeeds == surveySeeds)
+		summary->behavior = summary->maxPeriod == 1 ? "stable" : "periodic";
+	else if (summary->density > 0.5 && summary->growth >= 1.0)
+		summary->behavior = "explosive";
+	else
+		summary->behavior = "chaotic";
+}
+
+void* surveyWorker(void* arg) {
+	(void) arg;
+	LifeEngine engine;
+	if (!createEngine(&engine, surveySize, surveySize)) {
+		fprintf(stderr, "could not allocate an engine\n");
+		exit(-1);
+	}
+	RuleSummary summary;
+	char name[RULE_NAME_LENGTH];
+	int number;
+	while ((number = atomic_fetch_add(&nextRule, 1)) < NUM_LIFE_RULES) {
+		if (ruleDone[number])
+			continue;
+		surveyRule(&engine, number, &summary);
+		ruleName(ruleFromNumber(number), name);
+
+		pthread_mutex_lock(&surveyLock);
+		fprintf(surveyCSV, "%d,%s,%.1f,%.4f,%.3f,%.4f,%d,%d,%u,%s\n", number, name,
+				summary.meanPopulation, summary.density, summary.growth, summary.activity,
+				summary.periodicSeeds, summary.deadSeeds, summary.maxPeriod, summary.behavior);
+		//	what is in the file survives an interruption
+		if ((atomic_fetch_add(&rulesSurveyed, 1) & 255) == 255)
+			fflush(surveyCSV);
+		pthread_mutex_unlock(&surveyLock);
+	}
+	destroyEngine(&engine);
+	return NULL;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int runSurvey(int argc, char** argv) {
+	int numWorkers = 0, ok = (argc >= 2 && sscanf(argv[1], "%d", &numWorkers) == 1 && numWorkers >= 1);
+	for (int i=2; ok && i<argc; i++) {
+		int hasValue = (i+1 < argc);
+		if (strcmp(argv[i], "-seeds") == 0 && hasValue)
+			ok = sscanf(argv[++i], "%d", &surveySeeds) == 1 && surveySeeds >= 1;
+		else if (strcmp(argv[i], "-gens") == 0 && hasValue)
+			ok = sscanf(argv[++i], "%lu", &surveyGenerations) == 1;
+		else if (strcmp(argv[i], "-size") == 0 && hasValue)
+			ok = sscanf(argv[++i], "%d", &surveySize) == 1 && surveySize >= 3;
+		else if (strcmp(argv[i], "-boundary") == 0 && hasValue)
+			ok = parseBoundary(argv[++i], &surveyBoundary);
+		else
+			ok = 0;
+	}
+	if (!ok) {
+		fprintf(stderr, "usage: cell -survey results.csv numThreads [-seeds K] [-gens G] "
+				"[-size N] [-boundary dead|wrap]\n");
+		return -1;
+	}
+
+	ruleDone = (unsigned char*) calloc(NUM_LIFE_RULES, 1);
+	int endsWithNewline;
+	if (!readDoneRules(argv[0], &endsWithNewline)) {
+		fprintf(stderr, "%s is not a survey results file\n", argv[0]);
+		return -1;
+	}
+	int numDone = 0;
+	for (int k=0; k<NUM_LIFE_RULES; k++)
+		numDone += ruleDone[k];
+
+	surveyCSV = fopen(argv[0], "a");
+	if (surveyCSV == NULL) {
+		fprintf(stderr, "could not write to %s\n", argv[0]);
+		return -1;
+	}
+	fseek(surveyCSV, 0, SEEK_END);
+	if (ftell(surveyCSV) == 0)
+		fprintf(surveyCSV, "rule,name,meanPopulation,density,growth,activity,"
+				"periodicSeeds,deadSeeds,maxPeriod,behavior\n");
+	//	finish the line an interruption cut short, so it is ignored next time
+	else if (!endsWithNewline)
+		fprintf(surveyCSV, "\n");
+	if (numDone > 0)
+		fprintf(stderr, "resuming: %d rules already surveyed\n", numDone);
+
+	pthread_t* workers = (pthread_t*) malloc(numWorkers * sizeof(pthread_t));
+	uint64_t start = perfNow();
+	for (int k=0; k<numWorkers; k++)
+		pthread_create(workers + k, NULL, surveyWorker, NULL);
+	for (int k=0; k<numWorkers; k++)
+		pthread_join(workers[k], NULL);
+	double seconds = 1e-9 * (perfNow() - start);
+
+	fclose(surveyCSV);
+	int surveyed = atomic_load(&rulesSurveyed);
+	fprintf(stderr, "%d rules in %.1f s: %.1f rules/sec (%d threads)\n",
+			surveyed, seconds, surveyed / seconds, numWorkers);
+	free(workers);
+	free(ruleDone);
+	return 0;
+}
@@ -0,0 +1,27 @@
+//
+//  survey.h
+//  Cellular Automaton
+//
+//  Headless survey of all 2^18 Life-like rules: each rule is run on a few
+//  random grids and classified from cheap measures (population at half &
+//  full run, activity, period).  One line per rule is appended to a CSV
+//  file, and an interrupted survey resumes where it stopped.
+//
+//  A rule's number holds the birth digits in bits 0-8 and the survival
+//  digits in bits 9-17 (B3/S23 is 8 + (12 << 9) = 6152).
+//
+
+#ifndef SURVEY_H
+#define SURVEY_H
+
+#define NUM_LIFE_RULES	(1 << 18)
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	argv: results CSV file, number of threads, then optional
+//	-seeds K, -gens G, -size N, -boundary dead|wrap.  Returns the exit code
+int runSurvey(int argc, char** argv);
+
+#endif // SURVEY_H
@@ -0,0 +1,300 @@
+//
+//  engineBench.c
+//  Cellular Automaton
+//
+//  Times the three ways B3/S23 can be stepped on a torus, on one thread, from
+//  the same random grids at live densities of 10 to 90%: the application's
+//  per-cell path (-engine cell), its 4x4-block table (-engine block), and
+//  the bit-packed batch engine of the ensemble & survey modes.  Prints Mcells/s
+//  for each, and exits with 1 if the three ever end on different populations.
+//
+//  With -wide, compares the row & tiled layouts (-layout) on a wide grid
+//  instead: Mcells/s of both engines, and the L1 & L2 misses per cell of a
+//  generation of the per-cell path, from a replay of the cells it reads &
+//  writes through set-associative LRU caches (48 KB 12-way, 2 MB 16-way,
+//  64-byte lines), so that the misses can be compared on machines without
+//  performance counters.
+//
+//      ./engineBench [-layout rows|tiled] [SIZE [GENERATIONS]]   (1000 x 1000, 100 generations)
+//      ./engineBench -wide [ROWS COLS [GENERATIONS]]             (64 x 16384, 100 generations)
+//
+
+//	(main.c's functions & globals, without its main())
+#define main cellMain
+#include "../main.c"
+#undef main
+
+const int BENCH_DENSITIES[] = {10, 30, 50, 70, 90};
+//	(of the wide grids)
+#define WIDE_DENSITY		30
+
+#define CACHE_LINE_BITS		6
+
+typedef struct SimulatedCache {
+	int numSets, numWays;
+	//	line held by each way of each set, and when it was last used
+	uint64_t* lines;
+	uint64_t* lastUse;
+	uint64_t clock;
+	unsigned long misses;
+} SimulatedCache;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+void fillGrid(int density, unsigned int seed) {
+	srand(seed);
+	for (int i=0; i<numRows; i++)
+		for (int j=0; j<numCols; j++)
+			*gridCell(currentGrid, i, j) = (rand() % 100 < density);
+	refreshGridEdges(currentGrid, 1);
+}
+
+void fillGrids(LifeEngine* engine, int size, int density, unsigned int seed) {
+	fillGrid(density, seed);
+	memset(engine->cells, 0, (size_t) size * engine->words * sizeof(uint64_t));
+	for (int i=0; i<size; i++) {
+		uint64_t* row = engine->cells + (size_t) i * engine->words;
+		for (int j=0; j<size; j++)
+			row[j/64] |= (uint64_t) *gridCell(currentGrid, i, j) << (j & 63);
+	}
+}
+
+//	One thread owning the whole grid
+void startThread(void) {
+	numThreads = 1;
+	wrapFrame = 1;
+	rule = GAME_OF_LIFE_RULE;
+	threads = (ThreadInfo*) aligned_alloc(CACHE_LINE_SIZE, sizeof(ThreadInfo));
+	memset(threads, 0, sizeof(ThreadInfo));
+	threads[0].index = 1;
+	threads[0].endIndex = numRows;
+}
+
+void stopThread(void) {
+	poolFree(threads[0].rowHashes);
+	poolFree(threads[0].blockStates);
+	free(threads);
+}
+
+//	Runs the application's path on one slab; returns the seconds taken
+double timeGrid(int useBlocks, int numGenerations, unsigned long* population) {
+	blockTableAllowed = useBlocks;
+	updateBlockTable();
+	double start = currentTime();
+	for (int gen=0; gen<numGenerations; gen++) {
+		clearStats(&threads[0].stats[0]);
+		slabGeneration(threads, currentGrid, nextGrid, &threads[0].stats[0]);
+		swapGrids();
+	}
+	double seconds = currentTime() - start;
+	//	(the live cells of the last generation, as completeGeneration counts them)
+	*population = 0;
+	for (int k=1; k<MAX_CELL_STATES; k++)
+		*population += threads[0].stats[0].stateCount[k];
+	return seconds;
+}
+
+void createCache(SimulatedCache* cache, int size, int numWays) {
+	cache->numWays = numWays;
+	cache->numSets = (size >> CACHE_LINE_BITS) / numWays;
+	cache->lines = (uint64_t*) calloc((size_t) cache->numSets * numWays, sizeof(uint64_t));
+	cache->lastUse = (uint64_t*) calloc((size_t) cache->numSets * numWays, sizeof(uint64_t));
+	cache->clock = 0;
+	cache->misses = 0;
+}
+
+void destroyCache(SimulatedCache* cache) {
+	free(cache->lines);
+	free(cache->lastUse);
+}
+
+//	1 if the line was in the cache; else it replaces the set's least recently used one
+int cacheHit(SimulatedCache* cache, uint64_t line) {
+	uint64_t* lines = cache->lines + (size_t) (line % cache->numSets) * cache->numWays;
+	uint64_t* lastUse = cache->lastUse + (size_t) (line % cache->numSets) * cache->numWays;
+	//	(lines are stored plus 1, so that 0 is an empty way)
+	int oldest = 0;
+	cache->clock++;
+	for (int w=0; w<cache->numWays; w++) {
+		if (lines[w] == line + 1) {
+			lastUse[w] = cache->clock;
+			return 1;
+		}
+		if (lastUse[w] < lastUse[oldest])
+			oldest = w;
+	}
+	lines[oldest] = line + 1;
+	lastUse[oldest] = cache->clock;
+	cache->misses++;
+	return 0;
+}
+
+void accessCell(SimulatedCache* l1, SimulatedCache* l2, const int* cell) {
+	uint64_t line = (uintptr_t) cell >> CACHE_LINE_BITS;
+	if (!cacheHit(l1, line))
+		cacheHit(l2, line);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Replays the cells read & written by one generation of the per-cell path,
+ *	in slabGeneration's order (band after band, then row after row): the 3
+ *	x 3 cells around each cell, and the cell of the next grid.  Two
+ *	generations are replayed and only the misses of the second one count,
+ *	so that the caches are not empty.
+ *---------------------------------------------------------------------------
+ */
+void simulateMisses(double* l1Misses, double* l2Misses) {
+	SimulatedCache l1, l2;
+	createCache(&l1, 48 << 10, 12);
+	createCache(&l2, 2 << 20, 16);
+	for (int gen=0; gen<2; gen++) {
+		const Grid* grid = (gen == 0) ? currentGrid : nextGrid;
+		const Grid* next = (gen == 0) ? nextGrid : currentGrid;
+		l1.misses = l2.misses = 0;
+		for (int b=0; b<grid->numBands; b++) {
+			for (int i=0; i<numRows; i++) {
+				for (int j=grid->firstCol[b]; j<grid->firstCol[b+1]; j++) {
+					for (int di=-1; di<=1; di++)
+						for (int dj=-1; dj<=1; dj++)
+							accessCell(&l1, &l2, grid->band[b][i+di] + j + dj);
+					accessCell(&l1, &l2, next->band[b][i] + j);
+				}
+			}
+		}
+	}
+	*l1Misses = (double) l1.misses / ((double) numRows*numCols);
+	*l2Misses = (double) l2.misses / ((double) numRows*numCols);
+	destroyCache(&l1);
+	destroyCache(&l2);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Rows vs tiled bands of DEFAULT_TILE_COLS columns on one wide grid: the
+ *	rows of the row layout are too long for the three rows a generation
+ *	reads to stay in L1.  Exits with 1 if the layouts or the engines end on
+ *	different populations.
+ *---------------------------------------------------------------------------
+ */
+int benchLayouts(int argc, char** argv) {
+	numRows = globalNumRows = argc > 1 ? atoi(argv[1]) : 64;
+	numCols = argc > 2 ? atoi(argv[2]) : 16384;
+	int numGenerations = argc > 3 ? atoi(argv[3]) : 100;
+	if (numRows < 5 || numCols < 5 || numGenerations < 1) {
+		printf("usage: engineBench -wide [ROWS COLS [GENERATIONS]]\n");
+		return 1;
+	}
+	startThread();
+	tileCols = DEFAULT_TILE_COLS;
+
+	printf("B3/S23 on a %d x %d torus at %d%%, %d generations, 1 thread\n", numRows, numCols,
+		   WIDE_DENSITY, numGenerations);
+	printf("layout       L1 misses/cell  L2 misses/cell  cell (Mcells/s)  block (Mcells/s)\n");
+	double cellsDone = (double) numRows * numCols * numGenerations / 1e6;
+	unsigned long firstPopulation = 0;
+	int ok = 1;
+	for (int tiled=0; tiled<=1; tiled++) {
+		gridLayout = tiled ? LAYOUT_TILED : LAYOUT_ROWS;
+		currentGrid = allocateGrid();
+		nextGrid = allocateGrid();
+		double l1Misses, l2Misses;
+		simulateMisses(&l1Misses, &l2Misses);
+		double seconds[2];
+		for (int useBlocks=0; useBlocks<=1; useBlocks++) {
+			unsigned long population;
+			fillGrid(WIDE_DENSITY, WIDE_DENSITY);
+			seconds[useBlocks] = timeGrid(useBlocks, numGenerations, &population);
+			if (!tiled && !useBlocks)
+				firstPopulation = population;
+			if (population != firstPopulation) {
+				printf("%s layout, %s engine: population %lu instead of %lu\n", gridLayoutName(gridLayout),
+					   useBlocks ? "block" : "cell", population, firstPopulation);
+				ok = 0;
+			}
+		}
+		char layout[32];
+		snprintf(layout, sizeof(layout), tiled ? "tiled (%d)" : "rows", tileCols);
+		printf("%-11s  %14.3f  %14.3f  %15.0f  %16.0f\n", layout, l1Misses, l2Misses,
+			   cellsDone/seconds[0], cellsDone/seconds[1]);
+		destroyGrid(currentGrid);
+		destroyGrid(nextGrid);
+	}
+	stopThread();
+	return !ok;
+}
+
+double timeEngine(LifeEngine* engine, int numGenerations, unsigned long* population) {
+	double start = currentTime();
+	for (int gen=0; gen<numGenerations; gen++)
+		engineStep(engine);
+	double seconds = currentTime() - start;
+	*population = engine->population;
+	return seconds;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+	if (argc > 1 && strcmp(argv[1], "-wide") == 0)
+		return benchLayouts(argc-1, argv+1);
+	if (argc > 2 && strcmp(argv[1], "-layout") == 0) {
+		if (!parseGridLayout(argv[2], &gridLayout)) {
+			printf("-layout must be rows or tiled\n");
+			return 1;
+		}
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+	int size = argc > 1 ? atoi(argv[1]) : 1000;
+	int numGenerations = argc > 2 ? atoi(argv[2]) : 100;
+	if (size < 5 || numGenerations < 1) {
+		printf("usage: %s [-layout rows|tiled] [SIZE [GENERATIONS]]\n", argv[0]);
+		return 1;
+	}
+	numRows = globalNumRows = numCols = size;
+	startThread();
+	currentGrid = allocateGrid();
+	nextGrid = allocateGrid();
+	LifeEngine engine;
+	if (!createEngine(&engine, size, size)) {
+		printf("could not allocate a %d x %d engine\n", size, size);
+		return 1;
+	}
+
+	printf("B3/S23 on a %d x %d torus (%s layout), %d generations, 1 thread (Mcells/s)\n", size, size,
+		   gridLayoutName(gridLayout), numGenerations);
+	printf("density      cell     block    bit-packed\n");
+	double cellsDone = (double) size * size * numGenerations / 1e6;
+	int numDensities = sizeof(BENCH_DENSITIES) / sizeof(BENCH_DENSITIES[0]);
+	int ok = 1;
+	for (int k=0; k<numDensities; k++) {
+		int density = BENCH_DENSITIES[k];
+		unsigned long population[3];
+		double seconds[3];
+		startEngine(&engine, size, size, currentLifeRule(), BOUNDARY_WRAP, 1);
+		fillGrids(&engine, size, density, density);
+		seconds[0] = timeGrid(0, numGenerations, population + 0);
+		fillGrids(&engine, size, density, density);
+		seconds[1] = timeGrid(1, numGenerations, population + 1);
+		seconds[2] = timeEngine(&engine, numGenerations, population + 2);
+		printf("%5d%%  %8.0f  %8.0f  %12.0f\n", density, cellsDone/seconds[0],
+			   cellsDone/seconds[1], cellsDone/seconds[2]);
+		if (population[1] != population[0] || population[2] != population[0]) {
+			printf("density %d%%: populations %lu (cell), %lu (block), %lu (bit-packed) differ\n",
+				   density, population[0], population[1], population[2]);
+			ok = 0;
+		}
+	}
+
+	destroyEngine(&engine);
+	stopThread();
+	destroyGrid(currentGrid);
+	destroyGrid(nextGrid);
+	return !ok;
+}
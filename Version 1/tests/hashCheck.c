@@ -0,0 +1,175 @@
+//
+//  hashCheck.c
+//  Cellular Automaton
+//
+//  The generation hash used to find cycles: the application's (rowGeneration)
+//  must match the batch engine's (lifeEngine.c) on the same torus, cells and
+//  hash, for two-state & multi-state rules; and grids that only differ in
+//  their dying states must not be taken for a cycle.  Exits with 1 on the
+//  first failure.
+//
+
+//	(main.c's functions & globals, without its main())
+#define main cellMain
+#include "../main.c"
+#undef main
+
+typedef struct HashCase {
+	const char* rule;
+	int rows, cols;
+	int slabs;
+	GridLayout layout;
+	int bandCols;
+} HashCase;
+
+//	widths with & without a partial last word, bands cutting the words
+const HashCase HASH_CASES[] = {
+	{"B3/S23", 30, 100, 2, LAYOUT_ROWS, 0},
+	{"B2/S/C3", 30, 100, 3, LAYOUT_ROWS, 0},
+	{"B2/S345/C4", 17, 128, 2, LAYOUT_ROWS, 0},
+	{"B3/S23/C5", 40, 150, 4, LAYOUT_TILED, 48},
+	{"B2/S34/C9H", 24, 70, 3, LAYOUT_TILED, 16},
+	{"B2-a/S12/C6", 33, 64, 1, LAYOUT_ROWS, 0}
+};
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+void startGrid(const HashCase* test) {
+	numRows = globalNumRows = test->rows;
+	numCols = test->cols;
+	numThreads = test->slabs;
+	gridLayout = test->layout;
+	tileCols = test->bandCols;
+	wrapFrame = 1;
+	currentGrid = allocateGrid();
+	nextGrid = allocateGrid();
+	threads = (ThreadInfo*) aligned_alloc(CACHE_LINE_SIZE, numThreads*sizeof(ThreadInfo));
+	memset(threads, 0, numThreads*sizeof(ThreadInfo));
+	for (int t=0; t<numThreads; t++) {
+		threads[t].index = t+1;
+		threads[t].startIndex = numRows*t / numThreads;
+		threads[t].endIndex = numRows*(t+1) / numThreads;
+	}
+	clearCycleHistory();
+}
+
+//	One generation of every slab; returns the grid's hash
+uint64_t stepGrid(void) {
+	uint64_t hash = 0;
+	for (int t=0; t<numThreads; t++) {
+		clearStats(&threads[t].stats[0]);
+		slabGeneration(threads + t, currentGrid, nextGrid, &threads[t].stats[0]);
+		hash += threads[t].stats[0].hash;
+	}
+	swapGrids();
+	return hash;
+}
+
+void stopGrid(void) {
+	for (int t=0; t<numThreads; t++) {
+		poolFree(threads[t].rowHashes);
+		poolFree(threads[t].blockStates);
+	}
+	free(threads);
+	destroyGrid(currentGrid);
+	destroyGrid(nextGrid);
+}
+
+int engineState(const LifeEngine* engine, int row, int col) {
+	const uint64_t* planes = engine->cells + (size_t) row * engine->numPlanes * engine->words;
+	int state = 0;
+	for (int p=0; p<engine->numPlanes; p++)
+		state |= (int) ((planes[p*engine->words + col/64] >> (col & 63)) & 1) << p;
+	return state;
+}
+
+int runCase(const HashCase* test) {
+	startGrid(test);
+	LifeRule lifeRule;
+	if (!setCustomRule(test->rule) || !parseRule(test->rule, &lifeRule)) {
+		printf("%s is not a rule\n", test->rule);
+		return 0;
+	}
+	LifeEngine engine;
+	createEngine(&engine, numRows, numCols);
+	startEngine(&engine, numRows, numCols, lifeRule, BOUNDARY_WRAP, 12345);
+	for (int i=0; i<numRows; i++)
+		for (int j=0; j<numCols; j++)
+			*gridCell(currentGrid, i, j) = engineState(&engine, i, j);
+	refreshGridEdges(currentGrid, 1);
+
+	int ok = 1;
+	for (int gen=1; gen<=200 && ok; gen++) {
+		uint64_t hash = stepGrid();
+		engineStep(&engine);
+		for (int i=0; i<numRows && ok; i++) {
+			for (int j=0; j<numCols && ok; j++) {
+				if (*gridCell(currentGrid, i, j) != engineState(&engine, i, j)) {
+					printf("%s %dx%d: cell (%d, %d) differs from the batch engine at generation %d\n",
+						   test->rule, numRows, numCols, i, j, gen);
+					ok = 0;
+				}
+			}
+		}
+		if (ok && hash != engine.hash) {
+			printf("%s %dx%d: hash %016llx instead of the batch engine's %016llx at generation %d\n",
+				   test->rule, numRows, numCols, (unsigned long long) hash,
+				   (unsigned long long) engine.hash, gen);
+			ok = 0;
+		}
+	}
+	destroyEngine(&engine);
+	stopGrid();
+	return ok;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	With B3/S/C4, lone live cells die through states 2 & 3 while no cell is
+ *	born: the same cells are not dead for 3 generations in a row, in other
+ *	states each time.  No period may be found before the grid is empty.
+ *	(Under a B/S/C rule, a cell that oscillates goes through every state,
+ *	so a real oscillator's live & dying cells repeat with its states: only
+ *	such runs can make a hash of liveness alone find a false period.)
+ *---------------------------------------------------------------------------
+ */
+int checkDyingStates(void) {
+	const HashCase test = {"B3/S/C4", 20, 20, 2, LAYOUT_ROWS, 0};
+	startGrid(&test);
+	setCustomRule(test.rule);
+	for (int k=0; k<4; k++)
+		*gridCell(currentGrid, 3 + 4*k, 2 + 5*k) = 1;
+	refreshGridEdges(currentGrid, 1);
+
+	int ok = 1;
+	for (int gen=1; gen<=6 && ok; gen++) {
+		uint64_t hash = stepGrid();
+		unsigned long population = 0;
+		for (int i=0; i<numRows; i++)
+			for (int j=0; j<numCols; j++)
+				population += (*gridCell(currentGrid, i, j) != 0);
+		unsigned int period = recordGenerationHash(hash, gen);
+		if (period > 0 && population > 0) {
+			printf("B3/S/C4: dying cells taken for a cycle of period %u at generation %d\n", period, gen);
+			ok = 0;
+		}
+	}
+	stopGrid();
+	return ok;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int main(void) {
+	int numCases = sizeof(HASH_CASES) / sizeof(HASH_CASES[0]);
+	int numFailed = 0;
+	for (int k=0; k<numCases; k++)
+		numFailed += !runCase(HASH_CASES + k);
+	numFailed += !checkDyingStates();
+	printf("hashCheck: %d of %d cases pass\n", numCases + 1 - numFailed, numCases + 1);
+	return numFailed > 0;
+}
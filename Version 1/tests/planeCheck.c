@@ -0,0 +1,130 @@
+//
+//  planeCheck.c
+//  Cellular Automaton
+//
+//  Steps random soups on the unbounded plane (-plane) for several two-state
+//  rules, S0 ones included, and compares every generation with a naive grid
+//  large enough that nothing reaches its edge.  The soups straddle chunk
+//  edges on both sides of row & column 0.  Exits with 1 on the first
+//  mismatch.
+//
+
+//	(main.c's functions & globals, without its main())
+#define main cellMain
+#include "../main.c"
+#undef main
+
+typedef struct PlaneCase {
+	const char* rule;
+	//	top-left cell & size of the soup, and its density (percent)
+	long row, col;
+	int size, density;
+} PlaneCase;
+
+const PlaneCase PLANE_CASES[] = {
+	{"B3/S23", -20, -90, 40, 35},
+	{"B3/S023", -70, 40, 40, 20},
+	{"B1357/S02468", -10, -10, 20, 50},
+	{"B36/S125", 50, -30, 40, 40},
+	{"B2/S", -5, 60, 10, 30},
+	{"B3/S012345678", -40, -40, 48, 30}
+};
+
+#define PLANE_CASE_GENERATIONS	48
+//	(a cell can't move more than one row or column per generation)
+#define PLANE_CASE_MARGIN		(PLANE_CASE_GENERATIONS + 2)
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+void naivePlaneGeneration(const LifeRule* lifeRule, const unsigned char* cells, unsigned char* next, int size) {
+	for (int i=0; i<size; i++) {
+		for (int j=0; j<size; j++) {
+			int count = 0;
+			for (int di=-1; di<=1; di++) {
+				for (int dj=-1; dj<=1; dj++) {
+					int ni = i + di, nj = j + dj;
+					if ((di != 0 || dj != 0) && ni >= 0 && ni < size && nj >= 0 && nj < size)
+						count += cells[ni*size + nj];
+				}
+			}
+			uint16_t counts = cells[i*size + j] ? lifeRule->survival : lifeRule->birth;
+			next[i*size + j] = (counts >> count) & 1;
+		}
+	}
+}
+
+int runCase(const PlaneCase* test) {
+	LifeRule lifeRule;
+	if (!parseRule(test->rule, &lifeRule) || !planeRuleFits(&lifeRule)) {
+		printf("%s does not fit the plane\n", test->rule);
+		return 0;
+	}
+	//	the naive grid's cell (0, 0) is the plane's (top, left)
+	int size = test->size + 2*PLANE_CASE_MARGIN;
+	long top = test->row - PLANE_CASE_MARGIN, left = test->col - PLANE_CASE_MARGIN;
+	unsigned char* naive = (unsigned char*) calloc(size*size, 1);
+	unsigned char* naiveNext = (unsigned char*) calloc(size*size, 1);
+	SparsePlane testPlane;
+	createPlane(&testPlane, lifeRule);
+	srand(test->size*test->density);
+	for (int i=0; i<test->size; i++) {
+		for (int j=0; j<test->size; j++) {
+			int alive = (rand() % 100 < test->density);
+			naive[(i + PLANE_CASE_MARGIN)*size + j + PLANE_CASE_MARGIN] = alive;
+			setPlaneCell(&testPlane, test->row + i, test->col + j, alive);
+		}
+	}
+	tidyPlane(&testPlane);
+
+	int ok = 1;
+	for (int gen=1; gen<=PLANE_CASE_GENERATIONS && ok; gen++) {
+		GenerationStats stats;
+		clearStats(&stats);
+		stepPlaneChunks(&testPlane, 0, testPlane.numChunks, &stats);
+		advancePlane(&testPlane);
+		naivePlaneGeneration(&lifeRule, naive, naiveNext, size);
+		unsigned char* swap = naive;
+		naive = naiveNext;
+		naiveNext = swap;
+
+		unsigned long population = 0;
+		for (int i=0; i<size && ok; i++) {
+			for (int j=0; j<size; j++) {
+				int cell = planeCell(&testPlane, top + i, left + j);
+				if (cell != naive[i*size + j]) {
+					printf("%s: cell (%ld, %ld) is %d instead of %d at generation %d\n", test->rule,
+						   top + i, left + j, cell, naive[i*size + j], gen);
+					ok = 0;
+					break;
+				}
+				population += cell;
+			}
+		}
+		//	(and no live cell outside the naive grid)
+		if (ok && stats.stateCount[1] != population) {
+			printf("%s: population %lu instead of %lu at generation %d\n", test->rule,
+				   stats.stateCount[1], population, gen);
+			ok = 0;
+		}
+	}
+
+	destroyPlane(&testPlane);
+	free(naive);
+	free(naiveNext);
+	return ok;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int main(void) {
+	int numCases = sizeof(PLANE_CASES) / sizeof(PLANE_CASES[0]);
+	int numFailed = 0;
+	for (int k=0; k<numCases; k++)
+		numFailed += !runCase(PLANE_CASES + k);
+	printf("planeCheck: %d of %d cases match the naive grid\n", numCases - numFailed, numCases);
+	return numFailed > 0;
+}
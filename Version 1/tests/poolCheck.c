@@ -0,0 +1,165 @@
+//
+//  poolCheck.c
+//  Cellular Automaton
+//
+//  Runs the application's worker threads (barrier, wavefront, every engine,
+//  the plane) with malloc & co. wrapped by a counter, and checks that no
+//  call reaches them once the simulation is warmed up: past the first
+//  quarter of the generations, everything must come from the pool's free
+//  blocks.  Each case runs in its own process, which exits when its last
+//  generation is reached.  Exits with 1 on the first case that allocates.
+//
+
+#include <stdatomic.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//	(main.c's functions & globals, without its main())
+#define main cellMain
+#include "../main.c"
+#undef main
+
+typedef struct PoolCase {
+	const char* name;
+	int rows, cols, threads;
+	//	options, as on the command line
+	const char* options[8];
+} PoolCase;
+
+const PoolCase POOL_CASES[] = {
+	{"cell engine", 256, 256, 4, {"-engine", "cell", "-boundary", "wrap"}},
+	{"block engine, tiled", 256, 300, 3, {"-layout", "tiled", "-tilecols", "64", "-rebalance", "4"}},
+	{"Generations", 200, 200, 4, {"-rule", "B2/S/C3"}},
+	{"Larger than Life", 200, 200, 3, {"-rule", "R5,C2,M1,S34..58,B34..45,NM"}},
+	{"wavefront", 240, 240, 4, {"-wavefront", "3"}},
+	{"plane", 128, 128, 4, {"-plane", "-density", "0"}}
+};
+
+#define POOL_CASE_GENERATIONS	"1600"
+
+//	allocations made after the warm-up generations
+atomic_ulong steadyAllocations = 0;
+unsigned long warmUpGenerations;
+const PoolCase* runningCase;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* block, size_t size);
+void* __real_aligned_alloc(size_t alignment, size_t size);
+int __real_posix_memalign(void** block, size_t alignment, size_t size);
+
+void countAllocation(void) {
+	if (generation >= warmUpGenerations && generation < maxGenerations)
+		atomic_fetch_add(&steadyAllocations, 1);
+}
+
+void* __wrap_malloc(size_t size) {
+	countAllocation();
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+	countAllocation();
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* block, size_t size) {
+	countAllocation();
+	return __real_realloc(block, size);
+}
+
+void* __wrap_aligned_alloc(size_t alignment, size_t size) {
+	countAllocation();
+	return __real_aligned_alloc(alignment, size);
+}
+
+int __wrap_posix_memalign(void** block, size_t alignment, size_t size) {
+	countAllocation();
+	return __real_posix_memalign(block, alignment, size);
+}
+
+//	Registered with atexit(): the case's verdict is the process's status
+void reportAllocations(void) {
+	unsigned long count = atomic_load(&steadyAllocations);
+	if (count > 0) {
+		printf("%s: %lu allocations between generations %lu and %lu\n",
+			   runningCase->name, count, warmUpGenerations, maxGenerations);
+	}
+	fflush(stdout);
+	_exit(count > 0);
+}
+
+//	On the plane: a glider that keeps moving into new chunks, and blinkers
+//	that keep a few chunks alive
+void placePlaneCells(void) {
+	const long glider[5][2] = {{0, 1}, {1, 2}, {2, 0}, {2, 1}, {2, 2}};
+	for (int k=0; k<5; k++)
+		setPlaneCell(&plane, 10 + glider[k][0], 10 + glider[k][1], 1);
+	for (int b=0; b<3; b++) {
+		for (int k=0; k<3; k++)
+			setPlaneCell(&plane, 40 + 70*b, 200 + k, 1);
+	}
+	tidyPlane(&plane);
+}
+
+//	In a child process: the same start-up as main(), without the front end,
+//	the pipe & the socket; never returns
+void runCase(const PoolCase* test) {
+	const char* argv[16] = {"-headless", "-gens", POOL_CASE_GENERATIONS};
+	int argc = 3;
+	for (int k=0; k<8 && test->options[k] != NULL; k++)
+		argv[argc++] = test->options[k];
+	numRows = globalNumRows = test->rows;
+	numCols = test->cols;
+	maxNumThreads = test->threads;
+	//	(the cycles found & such are the application's messages, not the check's)
+	freopen("/dev/null", "w", stderr);
+	parseOptions(argc, (char**) argv);
+	warmUpGenerations = maxGenerations / 4;
+	runningCase = test;
+
+	updateBlockTable();
+	if (planeMode)
+		createPlane(&plane, currentLifeRule());
+	initializeCommandQueue();
+	initializeEditQueue();
+	initializeApplication();
+	if (planeMode)
+		placePlaneCells();
+	initializeExport(&exportOptions, numRows, numCols);
+	atexit(reportAllocations);
+	pthread_mutex_init(&myLock, NULL);
+	pthread_cond_init(&generationDone, NULL);
+	createWorkerThreads();
+	//	(completeGeneration exits once the last generation is reached)
+	for (int i=0; i<numThreads; i++)
+		pthread_join(threads[i].threadID, NULL);
+	_exit(1);
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int main(void) {
+	int numCases = sizeof(POOL_CASES) / sizeof(POOL_CASES[0]);
+	int numFailed = 0;
+	for (int k=0; k<numCases; k++) {
+		fflush(stdout);
+		pid_t child = fork();
+		if (child == 0)
+			runCase(POOL_CASES + k);
+		int status = 1;
+		if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			if (child < 0 || !WIFEXITED(status))
+				printf("%s: the run did not finish\n", POOL_CASES[k].name);
+			numFailed++;
+		}
+	}
+	printf("poolCheck: %d of %d cases allocate nothing once warmed up\n", numCases - numFailed, numCases);
+	return numFailed > 0;
+}
@@ -0,0 +1,143 @@
+//
+//  processCheck.c
+//  Cellular Automaton
+//
+//  Runs the application headless on one host, alone and split between N
+//  processes (-processes N, shared-memory halos), from the same seed, and
+//  checks that the processes' combined population & hash are the ones of
+//  the single process.  Each run is main() itself in a child process,
+//  whose final "generation G: population P, hash H" line is read from its
+//  stderr.  Exits with 1 on the first mismatch.
+//
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+//	(main.c's functions & globals, without its main())
+#define main cellMain
+#include "../main.c"
+#undef main
+
+typedef struct ProcessCase {
+	const char* rows;
+	const char* cols;
+	const char* threads;
+	//	options, as on the command line
+	const char* options[6];
+} ProcessCase;
+
+//	dead & wrapped edges, both engines & layouts, a multi-state rule
+const ProcessCase PROCESS_CASES[] = {
+	{"120", "150", "4", {"-boundary", "dead"}},
+	{"120", "150", "3", {"-boundary", "wrap", "-engine", "block"}},
+	{"100", "200", "4", {"-boundary", "wrap", "-layout", "tiled", "-tilecols", "64"}},
+	{"80", "90", "2", {"-rule", "B2/S/C3", "-boundary", "wrap"}}
+};
+
+const char* PROCESS_COUNTS[] = {"2", "3", "5", "20"};
+
+#define PROCESS_CASE_GENERATIONS	"300"
+#define PROCESS_CASE_SEED			"2024"
+
+typedef struct RunResult {
+	unsigned long generation, population;
+	unsigned long long hash;
+} RunResult;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+//	Runs main() in a child with the case's arguments (and -processes if
+//	processes is not NULL); returns 0 if it failed or printed no result
+int runApplication(const ProcessCase* test, const char* processes, RunResult* result) {
+	const char* argv[20] = {"cell", test->rows, test->cols, test->threads, "-headless",
+							"-gens", PROCESS_CASE_GENERATIONS, "-seed", PROCESS_CASE_SEED};
+	int argc = 9;
+	for (int k=0; k<6 && test->options[k] != NULL; k++)
+		argv[argc++] = test->options[k];
+	if (processes != NULL) {
+		argv[argc++] = "-processes";
+		argv[argc++] = processes;
+	}
+
+	int fds[2];
+	if (pipe(fds) != 0)
+		return 0;
+	fflush(stdout);
+	pid_t child = fork();
+	if (child == 0) {
+		//	(the results are on stderr; stdout only has the application's messages)
+		close(fds[0]);
+		dup2(fds[1], STDERR_FILENO);
+		close(fds[1]);
+		freopen("/dev/null", "w", stdout);
+		exit(cellMain(argc, (char**) argv));
+	}
+	close(fds[1]);
+	if (child < 0) {
+		close(fds[0]);
+		return 0;
+	}
+
+	//	(the processes started by the launcher hold the pipe too: read to the end)
+	char output[4096];
+	size_t length = 0;
+	ssize_t n;
+	while ((n = read(fds[0], output + length, sizeof(output) - 1 - length)) > 0) {
+		length += n;
+		if (length == sizeof(output) - 1)
+			length = 0;
+	}
+	output[length] = '\0';
+	close(fds[0]);
+	int status;
+	if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return 0;
+
+	int found = 0;
+	for (char* line = strtok(output, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+		found |= (sscanf(line, "generation %lu: population %lu, hash %llx",
+						 &result->generation, &result->population, &result->hash) == 3);
+	}
+	return found;
+}
+
+int runCase(const ProcessCase* test) {
+	RunResult alone;
+	if (!runApplication(test, NULL, &alone)) {
+		printf("%s x %s: the single process did not finish\n", test->rows, test->cols);
+		return 0;
+	}
+	int ok = 1;
+	int numCounts = sizeof(PROCESS_COUNTS) / sizeof(PROCESS_COUNTS[0]);
+	for (int k=0; k<numCounts; k++) {
+		RunResult split;
+		if (!runApplication(test, PROCESS_COUNTS[k], &split)) {
+			printf("%s x %s: %s processes did not finish\n", test->rows, test->cols, PROCESS_COUNTS[k]);
+			ok = 0;
+		} else if (split.generation != alone.generation || split.population != alone.population ||
+				   split.hash != alone.hash) {
+			printf("%s x %s: %s processes end on generation %lu, population %lu, hash %016llx "
+				   "instead of %lu, %lu, %016llx\n", test->rows, test->cols, PROCESS_COUNTS[k],
+				   split.generation, split.population, split.hash,
+				   alone.generation, alone.population, alone.hash);
+			ok = 0;
+		}
+	}
+	return ok;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int main(void) {
+	int numCases = sizeof(PROCESS_CASES) / sizeof(PROCESS_CASES[0]);
+	int numFailed = 0;
+	for (int k=0; k<numCases; k++)
+		numFailed += !runCase(PROCESS_CASES + k);
+	printf("processCheck: %d of %d cases give the same result on 1 to 20 processes\n",
+		   numCases - numFailed, numCases);
+	return numFailed > 0;
+}
@@ -0,0 +1,167 @@
+//
+//  torusCheck.c
+//  Cellular Automaton
+//
+//  Sends gliders across both seams of a torus, stepped by the application's
+//  own slabs (both layouts, both engines, several slab counts), and compares
+//  every generation with a naive grid whose neighbors are indexed modulo its
+//  size.  Exits with 1 on the first mismatch.
+//
+
+//	(main.c's functions & globals, without its main())
+#define main cellMain
+#include "../main.c"
+#undef main
+
+typedef struct TorusCase {
+	int rows, cols;
+	int slabs;
+	GridLayout layout;
+	int bandCols;
+	int blockEngine;
+} TorusCase;
+
+//	odd & even sizes, bands narrower than the grid, slabs of 1 row
+const TorusCase TORUS_CASES[] = {
+	{37, 53, 1, LAYOUT_ROWS, 0, 0},
+	{37, 53, 3, LAYOUT_ROWS, 0, 1},
+	{40, 64, 4, LAYOUT_TILED, 16, 0},
+	{40, 64, 4, LAYOUT_TILED, 16, 1},
+	{21, 130, 5, LAYOUT_TILED, 32, 1},
+	{24, 24, 24, LAYOUT_ROWS, 0, 1},
+	{61, 19, 2, LAYOUT_TILED, 16, 1}
+};
+
+//	a glider moving down & right, flipped for the other directions
+const char* GLIDER[3] = {".O.", "..O", "OOO"};
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+void naiveGeneration(const unsigned char* cells, unsigned char* next, int rows, int cols) {
+	for (int i=0; i<rows; i++) {
+		for (int j=0; j<cols; j++) {
+			int count = 0;
+			for (int di=-1; di<=1; di++) {
+				for (int dj=-1; dj<=1; dj++) {
+					if (di != 0 || dj != 0)
+						count += cells[((i + di + rows) % rows)*cols + (j + dj + cols) % cols];
+				}
+			}
+			int alive = cells[i*cols + j];
+			next[i*cols + j] = (count == 3) || (alive && count == 2);
+		}
+	}
+}
+
+void placeGlider(unsigned char* cells, int rows, int cols, int row, int col, int flipRows, int flipCols) {
+	for (int r=0; r<3; r++) {
+		for (int c=0; c<3; c++) {
+			int i = (row + (flipRows ? 2-r : r)) % rows;
+			int j = (col + (flipCols ? 2-c : c)) % cols;
+			cells[i*cols + j] = (GLIDER[r][c] == 'O');
+		}
+	}
+}
+
+int runCase(const TorusCase* test) {
+	numRows = globalNumRows = test->rows;
+	numCols = test->cols;
+	numThreads = test->slabs;
+	gridLayout = test->layout;
+	tileCols = test->bandCols;
+	blockTableAllowed = test->blockEngine;
+	wrapFrame = 1;
+	rule = GAME_OF_LIFE_RULE;
+	updateBlockTable();
+
+	int rows = test->rows, cols = test->cols;
+	unsigned char* naive = (unsigned char*) calloc(rows*cols, 1);
+	unsigned char* naiveNext = (unsigned char*) calloc(rows*cols, 1);
+	//	one glider going each way, each one cell off a seam
+	placeGlider(naive, rows, cols, rows-2, cols-2, 0, 0);
+	placeGlider(naive, rows, cols, rows/2, cols-2, 1, 0);
+	placeGlider(naive, rows, cols, rows-2, cols/2, 0, 1);
+	placeGlider(naive, rows, cols, 1, 1, 1, 1);
+
+	currentGrid = allocateGrid();
+	nextGrid = allocateGrid();
+	for (int i=0; i<rows; i++)
+		for (int j=0; j<cols; j++)
+			*gridCell(currentGrid, i, j) = naive[i*cols + j];
+	refreshGridEdges(currentGrid, 1);
+
+	threads = (ThreadInfo*) aligned_alloc(CACHE_LINE_SIZE, numThreads*sizeof(ThreadInfo));
+	memset(threads, 0, numThreads*sizeof(ThreadInfo));
+	for (int t=0; t<numThreads; t++) {
+		threads[t].index = t+1;
+		threads[t].startIndex = rows*t / numThreads;
+		threads[t].endIndex = rows*(t+1) / numThreads;
+	}
+
+	//	long enough for every glider to go around the torus a few times
+	int numGenerations = 4*(rows + cols);
+	int crossedRows = 0, crossedCols = 0;
+	int ok = 1;
+	for (int gen=1; gen<=numGenerations && ok; gen++) {
+		for (int t=0; t<numThreads; t++) {
+			clearStats(&threads[t].stats[0]);
+			slabGeneration(threads + t, currentGrid, nextGrid, &threads[t].stats[0]);
+		}
+		swapGrids();
+		naiveGeneration(naive, naiveNext, rows, cols);
+		unsigned char* swap = naive;
+		naive = naiveNext;
+		naiveNext = swap;
+
+		int topRow = 0, bottomRow = 0, leftCol = 0, rightCol = 0;
+		for (int i=0; i<rows && ok; i++) {
+			for (int j=0; j<cols; j++) {
+				int cell = *gridCell(currentGrid, i, j);
+				if (cell != naive[i*cols + j]) {
+					printf("torus %dx%d, %d slabs, %s layout, %s engine: cell (%d, %d) is %d instead of %d "
+						   "at generation %d\n", rows, cols, numThreads, gridLayoutName(gridLayout),
+						   blockTableReady ? "block" : "cell", i, j, cell, naive[i*cols + j], gen);
+					ok = 0;
+					break;
+				}
+				topRow |= (i == 0 && cell);
+				bottomRow |= (i == rows-1 && cell);
+				leftCol |= (j == 0 && cell);
+				rightCol |= (j == cols-1 && cell);
+			}
+		}
+		//	a glider straddling a seam has cells on both sides of it
+		crossedRows |= topRow && bottomRow;
+		crossedCols |= leftCol && rightCol;
+	}
+	if (ok && !(crossedRows && crossedCols)) {
+		printf("torus %dx%d: no glider crossed %s\n", rows, cols, crossedRows ? "the columns' seam" : "the rows' seam");
+		ok = 0;
+	}
+
+	for (int t=0; t<numThreads; t++) {
+		poolFree(threads[t].rowHashes);
+		poolFree(threads[t].blockStates);
+	}
+	free(threads);
+	destroyGrid(currentGrid);
+	destroyGrid(nextGrid);
+	free(naive);
+	free(naiveNext);
+	return ok;
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+int main(void) {
+	int numCases = sizeof(TORUS_CASES) / sizeof(TORUS_CASES[0]);
+	int numFailed = 0;
+	for (int k=0; k<numCases; k++)
+		numFailed += !runCase(TORUS_CASES + k);
+	printf("torusCheck: %d of %d cases match the naive torus\n", numCases - numFailed, numCases);
+	return numFailed > 0;
+}
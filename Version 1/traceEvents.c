@@ -0,0 +1,164 @@
+//
+//  traceEvents.c
+//  Cellular Automaton
+//
+//  A ring only keeps the most recent TRACE_RING_SIZE events of its thread.
+//  Writing the trace reads the rings while the threads keep recording, so
+//  it skips the oldest part of each full ring, which could be overwritten
+//  while we read it.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "perfCounters.h"
+#include "traceEvents.h"
+
+//	must be a power of 2
+#define TRACE_RING_SIZE		(1 << 16)
+#define TRACE_SAFETY_MARGIN	4096
+#define MAX_TRACED_THREADS	128
+
+//---------------------------------------------------------------------------
+//  Private data types
+//---------------------------------------------------------------------------
+
+typedef struct TraceEvent {
+	uint64_t timestamp;
+	unsigned char phase;
+	//	'B'egin or 'E'nd
+	char type;
+} TraceEvent;
+
+typedef struct TraceRing {
+	char name[32];
+	TraceEvent* events;
+	//	number of events ever recorded (only written by the owner thread)
+	_Alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t count;
+} TraceRing;
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+const char* TRACE_PHASE_NAME[NB_TRACE_PHASES] = {"compute", "wait", "swap", "render", "commands", "pace"};
+
+int tracingEnabled = 0;
+const char* traceFilePath = NULL;
+uint64_t traceStartTime;
+
+TraceRing traceRings[MAX_TRACED_THREADS];
+atomic_int numTraceRings = 0;
+__thread TraceRing* myTraceRing = NULL;
+
+pthread_mutex_t traceWriteLock = PTHREAD_MUTEX_INITIALIZER;
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void initializeTracing(const char* outputPath) {
+	if (outputPath == NULL)
+		return;
+	traceFilePath = outputPath;
+	traceStartTime = perfNow();
+	tracingEnabled = 1;
+}
+
+void traceRegisterThread(const char* name) {
+	if (!tracingEnabled || myTraceRing != NULL)
+		return;
+	int index = atomic_fetch_add(&numTraceRings, 1);
+	if (index >= MAX_TRACED_THREADS)
+		return;
+
+	TraceRing* ring = traceRings + index;
+	strncpy(ring->name, name, sizeof(ring->name)-1);
+	ring->events = (TraceEvent*) malloc(TRACE_RING_SIZE*sizeof(TraceEvent));
+	atomic_store_explicit(&ring->count, 0, memory_order_release);
+	myTraceRing = ring;
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Only the owner thread writes to its ring; the release store on the
+ *	count publishes the event to the thread writing the trace.
+ *---------------------------------------------------------------------------
+ */
+static inline void recordEvent(TracePhase phase, char type) {
+	TraceRing* ring = myTraceRing;
+	if (ring == NULL)
+		return;
+	uint64_t n = atomic_load_explicit(&ring->count, memory_order_relaxed);
+	TraceEvent* event = ring->events + (n & (TRACE_RING_SIZE-1));
+	event->timestamp = perfNow();
+	event->phase = (unsigned char) phase;
+	event->type = type;
+	atomic_store_explicit(&ring->count, n+1, memory_order_release);
+}
+
+void traceBegin(TracePhase phase) {
+	if (tracingEnabled)
+		recordEvent(phase, 'B');
+}
+
+void traceEnd(TracePhase phase) {
+	if (tracingEnabled)
+		recordEvent(phase, 'E');
+}
+
+int writeTrace(void) {
+	if (!tracingEnabled)
+		return 1;
+
+	pthread_mutex_lock(&traceWriteLock);
+	FILE* fp = fopen(traceFilePath, "w");
+	if (fp == NULL) {
+		pthread_mutex_unlock(&traceWriteLock);
+		fprintf(stderr, "could not write trace file %s\n", traceFilePath);
+		return 0;
+	}
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	int first = 1;
+	int numRings = atomic_load(&numTraceRings);
+	if (numRings > MAX_TRACED_THREADS)
+		numRings = MAX_TRACED_THREADS;
+
+	for (int k=0; k<numRings; k++) {
+		TraceRing* ring = traceRings + k;
+		fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				first ? "" : ",\n", k, ring->name);
+		first = 0;
+
+		uint64_t end = atomic_load_explicit(&ring->count, memory_order_acquire);
+		uint64_t start = 0;
+		if (end > TRACE_RING_SIZE - TRACE_SAFETY_MARGIN)
+			start = end - (TRACE_RING_SIZE - TRACE_SAFETY_MARGIN);
+
+		//	a ring that wrapped around may start with the end of a phase
+		//	whose beginning was overwritten: drop those unmatched ends
+		int depth = 0;
+		for (uint64_t n=start; n<end; n++) {
+			TraceEvent event = ring->events[n & (TRACE_RING_SIZE-1)];
+			if (event.type == 'B')
+				depth++;
+			else if (depth == 0)
+				continue;
+			else
+				depth--;
+
+			fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+					TRACE_PHASE_NAME[event.phase], event.type, k,
+					1e-3 * (double) (event.timestamp - traceStartTime));
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	int ok = !ferror(fp);
+	fclose(fp);
+	pthread_mutex_unlock(&traceWriteLock);
+	return ok;
+}
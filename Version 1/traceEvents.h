@@ -0,0 +1,41 @@
+//
+//  traceEvents.h
+//  Cellular Automaton
+//
+//  Optional timeline of what every thread is doing, written as Chrome
+//  trace-event JSON (open it in chrome://tracing or ui.perfetto.dev).
+//  Each thread records begin/end events into its own ring buffer, so
+//  tracing takes no lock; when tracing is off the calls return right away.
+//
+
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+typedef enum TracePhase {
+	TRACE_COMPUTE = 0,
+	TRACE_WAIT,
+	TRACE_SWAP,
+	TRACE_RENDER,
+	TRACE_COMMAND,
+	TRACE_PACE,
+	//
+	NB_TRACE_PHASES
+} TracePhase;
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void initializeTracing(const char* outputPath);
+//	each thread that records events must register once (name shown in the viewer)
+void traceRegisterThread(const char* name);
+void traceBegin(TracePhase phase);
+void traceEnd(TracePhase phase);
+//	writes the events recorded so far; returns 0 if the file could not be written
+int writeTrace(void);
+
+#endif // TRACE_EVENTS_H
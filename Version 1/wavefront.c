@@ -0,0 +1,169 @@
+//
+//  wavefront.c
+//  Cellular Automaton
+//
+//  All the bookkeeping is done under one lock, but each slab waits on its
+//  own condition: finishing a slab only wakes up its two neighbors.
+//
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "wavefront.h"
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+pthread_mutex_t wavefrontLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t* slabReady = NULL;
+
+int numSlabs = 0;
+unsigned int ringSize = 0;
+//	the first & last slabs are neighbors
+int periodicSlabs = 0;
+
+//	last generation each slab finished, and the one it is working on
+unsigned long* slabDone = NULL;
+unsigned long* slabStarted = NULL;
+//	number of slabs done with the generation kept in each buffer of the ring
+unsigned int doneCount[WAVEFRONT_MAX_RING];
+
+unsigned long completedGeneration = 0;
+//	set while a thread is completing generations
+int completing = 0;
+//	slabs don't go past this generation (0 --> no hold)
+unsigned long holdGeneration = 0;
+
+//---------------------------------------------------------------------------
+//	Local functions
+//---------------------------------------------------------------------------
+
+/*
+ *---------------------------------------------------------------------------
+ *	A slab computing generation gen reads its neighbors' rows of gen-1, and
+ *	overwrites the buffer of generation gen-ringSize, which must have been
+ *	read by everybody (including the export) and so completed.
+ *---------------------------------------------------------------------------
+ */
+int slabAbove(int slab) {
+	return (slab + numSlabs - 1) % numSlabs;
+}
+
+int slabBelow(int slab) {
+	return (slab + 1) % numSlabs;
+}
+
+int mayStart(int slab, unsigned long gen) {
+	if (holdGeneration != 0 && gen > holdGeneration)
+		return 0;
+	if (gen > completedGeneration + ringSize - 1)
+		return 0;
+	if ((slab > 0 || periodicSlabs) && slabDone[slabAbove(slab)] < gen-1)
+		return 0;
+	if ((slab < numSlabs-1 || periodicSlabs) && slabDone[slabBelow(slab)] < gen-1)
+		return 0;
+	return 1;
+}
+
+void wakeAllSlabs(void) {
+	for (int k=0; k<numSlabs; k++)
+		pthread_cond_signal(slabReady + k);
+}
+
+//---------------------------------------------------------------------------
+//	Public functions
+//---------------------------------------------------------------------------
+
+void initializeWavefront(int slabs, unsigned int ring, unsigned long firstGeneration,
+						 int periodic) {
+	numSlabs = slabs;
+	ringSize = ring;
+	periodicSlabs = periodic;
+	slabReady = (pthread_cond_t*) malloc(slabs*sizeof(pthread_cond_t));
+	slabDone = (unsigned long*) malloc(slabs*sizeof(unsigned long));
+	slabStarted = (unsigned long*) malloc(slabs*sizeof(unsigned long));
+	for (int k=0; k<slabs; k++) {
+		pthread_cond_init(slabReady + k, NULL);
+		slabDone[k] = firstGeneration;
+		slabStarted[k] = firstGeneration;
+	}
+	for (unsigned int k=0; k<WAVEFRONT_MAX_RING; k++)
+		doneCount[k] = 0;
+	completedGeneration = firstGeneration;
+}
+
+void setWavefrontPeriodic(int periodic) {
+	pthread_mutex_lock(&wavefrontLock);
+	periodicSlabs = periodic;
+	pthread_mutex_unlock(&wavefrontLock);
+}
+
+void waitForNeighbors(int slab, unsigned long gen) {
+	pthread_mutex_lock(&wavefrontLock);
+	while (!mayStart(slab, gen))
+		pthread_cond_wait(slabReady + slab, &wavefrontLock);
+	slabStarted[slab] = gen;
+	pthread_mutex_unlock(&wavefrontLock);
+}
+
+/*
+ *---------------------------------------------------------------------------
+ *	Generations are completed one at a time and in order: the slab that
+ *	finishes generation g only completes it if nobody is completing an
+ *	earlier generation; otherwise that thread will move on to g itself.
+ *---------------------------------------------------------------------------
+ */
+unsigned long finishSlab(int slab, unsigned long gen) {
+	unsigned long toComplete = 0;
+	pthread_mutex_lock(&wavefrontLock);
+	slabDone[slab] = gen;
+	doneCount[gen % ringSize]++;
+	if (slab > 0 || periodicSlabs)
+		pthread_cond_signal(slabReady + slabAbove(slab));
+	if (slab < numSlabs-1 || periodicSlabs)
+		pthread_cond_signal(slabReady + slabBelow(slab));
+	if (!completing && doneCount[(completedGeneration+1) % ringSize] == (unsigned int) numSlabs) {
+		completing = 1;
+		toComplete = completedGeneration + 1;
+	}
+	pthread_mutex_unlock(&wavefrontLock);
+	return toComplete;
+}
+
+unsigned long generationCompleted(unsigned long gen) {
+	unsigned long toComplete = 0;
+	pthread_mutex_lock(&wavefrontLock);
+	completedGeneration = gen;
+	doneCount[gen % ringSize] = 0;
+	if (doneCount[(gen+1) % ringSize] == (unsigned int) numSlabs)
+		toComplete = gen + 1;
+	else
+		completing = 0;
+	//	a buffer of the ring was freed: slabs that were far ahead may go on
+	wakeAllSlabs();
+	pthread_mutex_unlock(&wavefrontLock);
+	return toComplete;
+}
+
+unsigned long holdWavefront(void) {
+	pthread_mutex_lock(&wavefrontLock);
+	unsigned long highest = completedGeneration + 1;
+	for (int k=0; k<numSlabs; k++) {
+		if (slabStarted[k] > highest)
+			highest = slabStarted[k];
+	}
+	holdGeneration = highest;
+	pthread_mutex_unlock(&wavefrontLock);
+	return highest;
+}
+
+unsigned long heldGeneration(void) {
+	return holdGeneration;
+}
+
+void releaseWavefront(void) {
+	pthread_mutex_lock(&wavefrontLock);
+	holdGeneration = 0;
+	wakeAllSlabs();
+	pthread_mutex_unlock(&wavefrontLock);
+}
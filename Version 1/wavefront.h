@@ -0,0 +1,47 @@
+//
+//  wavefront.h
+//  Cellular Automaton
+//
+//  Point-to-point synchronization between the threads' slabs of rows, used
+//  instead of the generation barrier.  A slab may compute generation g as
+//  soon as its two neighboring slabs are done with generation g-1, so fast
+//  slabs run a few generations ahead of slow, distant ones.  Generation g
+//  is kept in buffer g % ringSize of a ring of grids; a slab never gets more
+//  than ringSize-1 generations ahead of the last completed generation, so
+//  it never overwrites a grid somebody still needs.
+//
+
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+//	largest ring of grids (so at most 7 generations of lead)
+#define WAVEFRONT_MAX_RING	8
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+//	Slabs are numbered 0 to numSlabs-1 from the top; firstGeneration is the
+//	generation of the grid the slabs start from.  On a periodic grid, the
+//	first & last slabs are neighbors.
+void initializeWavefront(int numSlabs, unsigned int ringSize, unsigned long firstGeneration,
+						 int periodic);
+//	Only called while the slabs are held
+void setWavefrontPeriodic(int periodic);
+//	Blocks until the slab may compute generation gen
+void waitForNeighbors(int slab, unsigned long gen);
+//	Records that the slab is done with generation gen.  Returns the generation
+//	the caller must now complete (stats, export...), or 0 if it has nothing to do
+unsigned long finishSlab(int slab, unsigned long gen);
+//	Called once the caller completed generation gen.  Returns the next one to
+//	complete (already done by all slabs) or 0
+unsigned long generationCompleted(unsigned long gen);
+
+//	Stops the slabs at the highest generation one of them has started, and
+//	returns that generation.  Only called while completing a generation.
+unsigned long holdWavefront(void);
+//	0 if the slabs are not being held
+unsigned long heldGeneration(void);
+void releaseWavefront(void);
+
+#endif // WAVEFRONT_H
@@ -50,8 +50,8 @@ elif [[ $version -eq 2 ]]; then
 fi
 
 # compile the main c file
-# gcc main.c gl_frontEnd.c -lm -lpthread -framework OpenGL -framework GLUT -o cell
-gcc main.c gl_frontEnd.c -lGL -lglut -lpthread -o cell
+# gcc *.c -lm -lpthread -framework OpenGL -framework GLUT -o cell
+gcc *.c -lGL -lglut -lpthread -lm -o cell
 
 # launch the program in the background
 ./cell $1 $2 $3 &
@@ -87,7 +87,7 @@ while [[ $keepGoing -eq 1 ]]; do
 	elif [[ $commands = "color on" ]]; then 
 		echo $commands>namedPipe
 		echo "Color Mode on"
-	elif [[ $commands = "color Mode Off" ]]; then
+	elif [[ $commands = "color off" ]]; then
 		echo $commands>namedPipe
 		echo "Color Mode Off"
 	elif [[ $commands = "speedup" ]]; then